@@ -198,7 +198,7 @@ const char* CharX::construct_ansi_escseq(CharX& cx, const char* str) noexcept
                 // Reset the index of the buffer.
                 idx = 0;
             }
-            else if ((('a' <= c) and (c <= 'z')) or (('A' <= c) and (c <= 'Z')))
+            else if ((('a' <= c) and (c <= 'z')) or (('A' <= c) and (c <= 'Z')) or (c == '~'))
             {
                 // Append the integer written in the buffer.
                 if (idx > 0)
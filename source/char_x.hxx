@@ -18,6 +18,8 @@
 #define CHARX_VALUE_KEY_DOWN  (0x425b1b)  // ^[[B => [0x1b,0x5b,0x42] => 0x425b1b
 #define CHARX_VALUE_KEY_RIGHT (0x435b1b)  // ^[[C => [0x1b,0x5b,0x43] => 0x435b1b
 #define CHARX_VALUE_KEY_LEFT  (0x445b1b)  // ^[[D => [0x1b,0x5b,0x44] => 0x445b1b
+#define CHARX_VALUE_KEY_PGUP  (0x7e055b1b)  // ^[[5~ => [0x1b,0x5b,0x05,0x7e] => 0x7e055b1b
+#define CHARX_VALUE_KEY_PGDN  (0x7e065b1b)  // ^[[6~ => [0x1b,0x5b,0x06,0x7e] => 0x7e065b1b
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Class prototype definition
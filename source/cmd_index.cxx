@@ -0,0 +1,177 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ source file: cmd_index.cxx                                                               ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Include the primary header.
+#include "cmd_index.hxx"
+
+// Include the headers of STL.
+#include <algorithm>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+// Include the headers of custom modules.
+#include "hist_search.hxx"
+#include "utils.hxx"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// CmdIndex: Constructors
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+CmdIndex::CmdIndex(void) : commands(nullptr)
+{ /* Do nothing */ }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// CmdIndex: Member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+CmdIndex::Commands CmdIndex::get(const String& env_path) noexcept
+{   // {{{
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    // Split PATH by ':' and remove duplicated directories.
+    Vector<String> targets;
+    for (const String& dir : split(env_path, ":"))
+        if ((dir.size() > 0) and (std::find(targets.begin(), targets.end(), dir) == targets.end()))
+            targets.push_back(dir);
+
+    bool changed = (this->commands == nullptr) or (env_path != this->env_path);
+
+    for (const String& dir : targets)
+    {
+        struct stat st;
+
+        // Forget the directory if it is removed.
+        if ((::stat(dir.c_str(), &st) != 0) or (not S_ISDIR(st.st_mode)))
+        {
+            changed |= (this->dirs.erase(dir) > 0);
+            continue;
+        }
+
+        const int64_t mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+
+        // Use the cached names if the directory is not modified.
+        const auto iter = this->dirs.find(dir);
+        if ((iter != this->dirs.end()) and (iter->second.mtime == mtime) and iter->second.trusted)
+            continue;
+
+        // The directory may be modified again within the resolution of the mtime if it is read
+        // just after the modification. Such entries are read again at the next lookup.
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+
+        Entry entry = {mtime, now.tv_sec > st.st_mtim.tv_sec + 1, CmdIndex::scan(dir)};
+
+        changed |= (iter == this->dirs.end()) or (iter->second.names != entry.names);
+        this->dirs[dir] = std::move(entry);
+    }
+
+    if (not changed)
+        return this->commands;
+
+    // Merge the names of all directories in PATH.
+    Vector<std::string_view> merged;
+    for (const String& dir : targets)
+    {
+        const auto iter = this->dirs.find(dir);
+        if (iter != this->dirs.end())
+            merged.insert(merged.end(), iter->second.names.begin(), iter->second.names.end());
+    }
+
+    // Sort the array of command names and remove duplicated names.
+    std::sort(merged.begin(), merged.end());
+    merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+
+    // Copy the names to the arena.
+    std::shared_ptr<Names> result = std::make_shared<Names>();
+    result->offsets.reserve(merged.size());
+    result->masks.reserve(merged.size());
+
+    for (const std::string_view& name : merged)
+    {
+        result->offsets.push_back(static_cast<uint32_t>(result->arena.size()));
+        result->arena.append(name);
+        result->arena.push_back('\0');
+        result->masks.push_back(HistSearch::charmask(name));
+    }
+
+    this->env_path = env_path;
+    this->commands = std::move(result);
+
+    return this->commands;
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// CmdIndex: Static functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Pair<uint32_t, uint32_t> CmdIndex::range(const Names& names, const String& prefix) noexcept
+{   // {{{
+
+    const auto get_name = [&names](uint32_t offset) noexcept -> std::string_view
+    { return std::string_view(names.arena.data() + offset); };
+
+    // The names which start with the prefix are contiguous in the sorted order, and follow the
+    // names which are less than the prefix.
+    const auto iter_bgn = std::partition_point(names.offsets.begin(), names.offsets.end(), [&](uint32_t offset) noexcept
+    { return get_name(offset) < prefix; });
+
+    const auto iter_end = std::partition_point(iter_bgn, names.offsets.end(), [&](uint32_t offset) noexcept
+    { return get_name(offset).starts_with(prefix); });
+
+    return {static_cast<uint32_t>(iter_bgn - names.offsets.begin()), static_cast<uint32_t>(iter_end - names.offsets.begin())};
+
+}   // }}}
+
+std::string_view CmdIndex::name(const Names& names, uint32_t index) noexcept
+{   // {{{
+
+    return std::string_view(names.arena.data() + names.offsets[index]);
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// CmdIndex: Private member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Vector<String> CmdIndex::scan(const String& dir) noexcept
+{   // {{{
+
+    Vector<String> names;
+
+    DIR* dp = opendir(dir.c_str());
+    if (dp == nullptr)
+        return names;
+
+    while (const struct dirent* ent = readdir(dp))
+    {
+        unsigned char type = ent->d_type;
+
+        // Get the file type if the file system does not provide it.
+        if (type == DT_UNKNOWN)
+        {
+            struct stat st;
+            if (fstatat(dirfd(dp), ent->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+            else if (S_ISREG(st.st_mode))                                       type = DT_REG;
+            else if (S_ISLNK(st.st_mode))                                       type = DT_LNK;
+        }
+
+        // Append regular files and symbolic links.
+        if ((type == DT_REG) or (type == DT_LNK))
+            names.emplace_back(ent->d_name);
+    }
+
+    closedir(dp);
+
+    // Sort the names to compare them with the previous scan.
+    std::sort(names.begin(), names.end());
+
+    return names;
+
+}   // }}}
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
@@ -0,0 +1,148 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ header file: cmd_index.hxx                                                               ///
+///                                                                                              ///
+/// This file defines the class `CmdIndex` which keeps the names of the commands in PATH during  ///
+/// the session. The names are stored for each directory with its modification time, so that a   ///
+/// directory is read again only when its mtime changes, and a lookup of unchanged PATH costs    ///
+/// one stat call per directory. PATH is given at each lookup, so the changes of the environment ///
+/// variable (e.g. `set -x PATH ...`) are reflected without rescanning the known directories.    ///
+/// The merged names are stored in a contiguous arena in the sorted order, so that the commands  ///
+/// which start with a prefix are found by a binary search. The character masks of the names     ///
+/// are also stored contiguously to filter the names quickly in the fuzzy matching.              ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CMD_INDEX_HXX
+#define CMD_INDEX_HXX
+
+// Include the headers of STL.
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+// Include the headers of custom modules.
+#include "dtypes.hxx"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Class definitions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class CmdIndex
+{
+    public:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Data types
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        typedef struct Names
+        {
+            String           arena;    // Command names terminated by '\0'.
+            Vector<uint32_t> offsets;  // Offsets of the names in the arena in the sorted order.
+            Vector<uint64_t> masks;    // Character masks of the names for the fuzzy matching.
+        }
+        Names;
+        // Sorted and unique command names.
+
+        typedef std::shared_ptr<const Names> Commands;
+        // Command names which are immutable and shared with the callers. They are replaced by
+        // new ones when PATH or its directories are modified.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Constructors and destructors
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        CmdIndex(void);
+        // [Abstract]
+        //   Constructor of CmdIndex. No directory is read until the first lookup.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        Commands get(const String& env_path) noexcept;
+        // [Abstract]
+        //   Returns the names of the commands in the given PATH. The directories which are new or
+        //   modified since the last lookup are read again. This function is thread-safe.
+        //
+        // [Args]
+        //   env_path (const String&): [IN] Value of the environment variable PATH.
+        //
+        // [Returns]
+        //   (Commands): Sorted and unique command names.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Static functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        static Pair<uint32_t, uint32_t> range(const Names& names, const String& prefix) noexcept;
+        // [Abstract]
+        //   Returns the range of the names which start with the given prefix by a binary search.
+        //
+        // [Args]
+        //   names  (const Names&) : [IN] Command names.
+        //   prefix (const String&): [IN] Prefix of the command names.
+        //
+        // [Returns]
+        //   (Pair<uint32_t, uint32_t>): Begin and end indices of the matched names.
+
+        static std::string_view name(const Names& names, uint32_t index) noexcept;
+        // [Abstract]
+        //   Returns the name of the given index.
+        //
+        // [Args]
+        //   names (const Names&): [IN] Command names.
+        //   index (uint32_t)    : [IN] Index of the name in the sorted order.
+        //
+        // [Returns]
+        //   (std::string_view): Command name which refers to the arena.
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private data types
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        typedef struct Entry
+        {
+            int64_t        mtime;    // Modification time of the directory in nanoseconds.
+            bool           trusted;  // False if the directory was read within 1 second after its mtime.
+            Vector<String> names;    // Names of the regular files and symbolic links.
+        }
+        Entry;
+        // Cached names of the commands in a directory.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member variables
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        Map<String, Entry> dirs;
+        // Cached directories, including the ones removed from PATH (they may be added again,
+        // e.g. by activating a virtual environment).
+
+        String env_path;
+        // PATH of the current command names.
+
+        Commands commands;
+        // Current command names.
+
+        std::mutex mutex;
+        // Mutex for the member variables.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        static Vector<String> scan(const String& dir) noexcept;
+        // [Abstract]
+        //   Read the names of the regular files and symbolic links in the directory.
+        //
+        // [Args]
+        //   dir (const String&): [IN] Target directory.
+        //
+        // [Returns]
+        //   (Vector<String>): Names of the entries (empty if failed to open the directory).
+};
+
+#endif
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
@@ -0,0 +1,276 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ source file: cmd_pool.cxx                                                                ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Include the primary header.
+#include "cmd_pool.hxx"
+
+// Include the headers of STL.
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Environment variables passed to the child processes.
+extern char** environ;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// CmdPool: Constructors and destructors
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+CmdPool::CmdPool(uint8_t n_workers) : next_id(1), stopping(false)
+{   // {{{
+
+    // Start the worker threads.
+    for (uint8_t idx = 0; idx < std::max<uint8_t>(n_workers, 1); ++idx)
+        this->workers.emplace_back(&CmdPool::run, this);
+
+}   // }}}
+
+CmdPool::~CmdPool()
+{   // {{{
+
+    // Drop the pending requests and kill the running commands, so that the destructor never
+    // waits for slow commands.
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        this->stopping = true;
+        this->pending.clear();
+
+        for (auto& [id, request] : this->running)
+        {
+            if (request.second > 0)
+                kill(-request.second, SIGKILL);
+
+            request.second = 0;
+        }
+    }
+    this->cond.notify_all();
+
+    // Wait until all worker threads stop.
+    for (std::thread& worker : this->workers)
+        worker.join();
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// CmdPool: Member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t CmdPool::submit(const String& command) noexcept
+{   // {{{
+
+    uint64_t id_new = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        // Share the request if the same command is already pending or running.
+        for (const auto& [id, cmd] : this->pending)
+            if (cmd == command)
+                return id;
+
+        for (const auto& [id, request] : this->running)
+            if (request.first == command)
+                return id;
+
+        id_new = this->next_id++;
+        this->pending.emplace_back(id_new, command);
+    }
+    this->cond.notify_all();
+
+    return id_new;
+
+}   // }}}
+
+void CmdPool::cancel(uint64_t id) noexcept
+{   // {{{
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        // Drop the pending request.
+        const auto predicate = [id](const Pair<uint64_t, String>& request) noexcept -> bool
+        { return request.first == id; };
+
+        this->pending.erase(std::remove_if(this->pending.begin(), this->pending.end(), predicate), this->pending.end());
+
+        // Kill the running command. The worker thread discards the output because the request
+        // is no longer in the running list.
+        const auto iter = this->running.find(id);
+        if (iter != this->running.end())
+        {
+            if (iter->second.second > 0)
+                kill(-iter->second.second, SIGKILL);
+
+            this->running.erase(iter);
+        }
+
+        // Discard the output if already finished.
+        this->results.erase(id);
+    }
+    this->cond.notify_all();
+
+}   // }}}
+
+bool CmdPool::poll(uint64_t id, float timeout, String& output) noexcept
+{   // {{{
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    // Returns true if the request finished or is unknown (e.g. cancelled).
+    const auto predicate = [this, id]() noexcept -> bool
+    {
+        const auto is_target = [id](const Pair<uint64_t, String>& request) noexcept -> bool
+        { return request.first == id; };
+
+        const bool is_pending = std::any_of(this->pending.begin(), this->pending.end(), is_target);
+
+        return this->results.contains(id) or ((not is_pending) and (not this->running.contains(id)));
+    };
+
+    if (timeout > 0)
+        this->cond.wait_for(lock, std::chrono::duration<float>(timeout), predicate);
+
+    const auto iter = this->results.find(id);
+    if (iter == this->results.end())
+        return false;
+
+    output = std::move(iter->second);
+    this->results.erase(iter);
+
+    return true;
+
+}   // }}}
+
+bool CmdPool::finished(uint64_t id) noexcept
+{   // {{{
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    return this->results.contains(id);
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// CmdPool: Private member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void CmdPool::run(void) noexcept
+{   // {{{
+
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+
+        // Wait for a new request.
+        this->cond.wait(lock, [this]() noexcept { return this->stopping or (this->pending.size() > 0); });
+
+        if (this->stopping)
+            return;
+
+        // Move the request to the running list.
+        const auto [id, command] = this->pending.front();
+        this->pending.pop_front();
+        this->running[id] = {command, 0};
+
+        // Run the command without the lock.
+        lock.unlock();
+        String output = this->execute(id, command);
+        lock.lock();
+
+        // Store the output unless the request was cancelled while running.
+        if (this->running.contains(id))
+        {
+            this->results[id] = std::move(output);
+            this->running.erase(id);
+        }
+
+        lock.unlock();
+        this->cond.notify_all();
+    }
+
+}   // }}}
+
+String CmdPool::execute(uint64_t id, const String& command) noexcept
+{   // {{{
+
+    String output;
+
+    // Create a pipe to read the standard output.
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0)
+        return output;
+
+    // The child reads nothing from the terminal (it is used by the command loop), and the error
+    // output is discarded like `run_command`. The child runs in a new process group so that the
+    // whole pipeline can be killed at once.
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+    posix_spawnattr_setpgroup(&attr, 0);
+
+    pid_t pid = 0;
+    char* argv[] = {const_cast<char*>("/bin/sh"), const_cast<char*>("-c"), const_cast<char*>(command.c_str()), nullptr};
+    const int status = posix_spawn(&pid, "/bin/sh", &actions, &attr, argv, environ);
+
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    close(fds[1]);
+
+    if (status != 0)
+    {
+        close(fds[0]);
+        return output;
+    }
+
+    // Register the process ID to be killed on cancel, or kill it now if already cancelled.
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        const auto iter = this->running.find(id);
+        if (iter != this->running.end()) iter->second.second = pid;
+        else                             kill(-pid, SIGKILL);
+    }
+
+    // Read the standard output until the command finishes.
+    char buffer[4096];
+    while (true)
+    {
+        const ssize_t n = read(fds[0], buffer, sizeof(buffer));
+
+        if (n < 0 and errno == EINTR) continue;
+        if (n <= 0) break;
+
+        output.append(buffer, static_cast<size_t>(n));
+    }
+    close(fds[0]);
+
+    // The process group must not be killed after the process is reaped (the ID can be reused).
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        const auto iter = this->running.find(id);
+        if (iter != this->running.end())
+            iter->second.second = 0;
+    }
+
+    while ((waitpid(pid, nullptr, 0) < 0) and (errno == EINTR))
+    { /* Do nothing, just retry if interrupted. */ }
+
+    return output;
+
+}   // }}}
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
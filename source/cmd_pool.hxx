@@ -0,0 +1,128 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ header file: cmd_pool.hxx                                                                ///
+///                                                                                              ///
+/// This file defines the class `CmdPool` which runs shell commands of completion providers on   ///
+/// worker threads. Each request has a unique ID, and a request which is no longer needed can be ///
+/// cancelled, where the running command is killed and its output is discarded. Therefore, the   ///
+/// command loop never waits for a slow provider (e.g. `docker container ls`).                   ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CMD_POOL_HXX
+#define CMD_POOL_HXX
+
+// Include the headers of STL.
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <sys/types.h>
+#include <thread>
+
+// Include the headers of custom modules.
+#include "dtypes.hxx"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Class definitions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class CmdPool
+{
+    public:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Constructors and destructors
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+         explicit CmdPool(uint8_t n_workers);
+        ~CmdPool();
+        // [Abstract]
+        //   Constructor and destructor of CmdPool. The destructor drops all pending requests,
+        //   kills all running commands, and stops the worker threads.
+        //
+        // [Args]
+        //   n_workers (uint8_t): [IN] Number of worker threads (at least one).
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        uint64_t submit(const String& command) noexcept;
+        // [Abstract]
+        //   Request to run the given command. This function returns immediately. If the same
+        //   command is already pending or running, the ID of the request is returned instead.
+        //
+        // [Args]
+        //   command (const String&): [IN] Shell command.
+        //
+        // [Returns]
+        //   (uint64_t): ID of the request (IDs increase monotonically and never be zero).
+
+        void cancel(uint64_t id) noexcept;
+        // [Abstract]
+        //   Cancel the given request. The pending request is dropped, and the running command is
+        //   killed. The output of the request is discarded.
+        //
+        // [Args]
+        //   id (uint64_t): [IN] ID of the request.
+
+        bool poll(uint64_t id, float timeout, String& output) noexcept;
+        // [Abstract]
+        //   Get the output of the given request if finished. The output can be obtained only once.
+        //
+        // [Args]
+        //   id      (uint64_t): [IN ] ID of the request.
+        //   timeout (float)   : [IN ] Maximum time to wait for the request in seconds.
+        //   output  (String&) : [OUT] Standard output of the command.
+        //
+        // [Returns]
+        //   (bool): True if the request finished and the output is stored.
+
+        bool finished(uint64_t id) noexcept;
+        // [Abstract]
+        //   Returns true if the given request finished (i.e. `poll` will return immediately).
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member variables
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        uint64_t next_id;
+        // ID of the next request.
+
+        Deque<Pair<uint64_t, String>> pending;
+        // Requests waiting to be run (pairs of ID and command).
+
+        Map<uint64_t, Pair<String, pid_t>> running;
+        // Running requests (pairs of command and process ID, the process ID is zero until spawned).
+
+        Map<uint64_t, String> results;
+        // Outputs of the finished requests.
+
+        bool stopping;
+        // True if the worker threads should stop.
+
+        std::mutex mutex;
+        // Mutex for the member variables above.
+
+        std::condition_variable cond;
+        // Condition variable to notify new requests and finished requests.
+
+        Vector<std::thread> workers;
+        // Worker threads.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        void run(void) noexcept;
+        // [Abstract]
+        //   Main loop of the worker threads.
+
+        String execute(uint64_t id, const String& command) noexcept;
+        // [Abstract]
+        //   Run the command in a new process group and returns its standard output.
+};
+
+#endif
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
@@ -59,7 +59,7 @@ Tuple<StringX, StringX> command_cd(const Vector<StringX>& tokens) noexcept
 
 }   // }}}
 
-Tuple<StringX, StringX> command_exec(const Vector<StringX>& tokens) noexcept
+Tuple<StringX, StringX> command_exec(const Vector<StringX>& tokens, int32_t* status) noexcept
 {   // {{{
 
     // Generate command string by concatenating all tokens and run it.
@@ -68,6 +68,9 @@ Tuple<StringX, StringX> command_exec(const Vector<StringX>& tokens) noexcept
     // Append the result value to NiShiKi internal variables.
     variables["?"] = std::to_string(res);
 
+    if (status != nullptr)
+        *status = res;
+
     return {StringX(""), StringX("")};
 
 }   // }}}
@@ -169,9 +172,13 @@ CommandRunner::CommandRunner(void)
 // CommandRunner: Member functions
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Tuple<StringX, StringX> CommandRunner::run(const StringX& command) const noexcept
+Tuple<StringX, StringX> CommandRunner::run(const StringX& command, int32_t* status) const noexcept
 {   // {{{
 
+    // NiShiKi-special commands are regarded as successful.
+    if (status != nullptr)
+        *status = 0;
+
     // Clear next editing buffer.
     StringX lhs_next, rhs_next;
 
@@ -229,7 +236,7 @@ Tuple<StringX, StringX> CommandRunner::run(const StringX& command) const noexcep
         return command_plugin(tokens);
 
     // Process other commands: call external command.
-    else return command_exec(tokens);
+    else return command_exec(tokens, status);
 
 }   // }}}
 
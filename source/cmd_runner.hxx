@@ -31,14 +31,16 @@ class CommandRunner
         // Member functions
         ////////////////////////////////////////////////////////////////////////////////////////////
 
-        Tuple<StringX, StringX> run(const StringX& command) const noexcept;
+        Tuple<StringX, StringX> run(const StringX& command, int32_t* status = nullptr) const noexcept;
         // [Abstract]
         //   Run the given command. New strings for the next editing buffer will be returned. This
         //   function can accept both shell command and NiShiKi-special command (cd, alias, plugin
         //   command, etc.)
         //
         // [Args]
-        //   input (const StringX&): [IN] Command string.
+        //   input  (const StringX&): [IN ] Command string.
+        //   status (int32_t*)      : [OUT] Raw status of the command returned by std::system
+        //                                  (zero for NiShiKi-special commands). Ignored if null.
         //
         // [Returns]
         //   (Tuple<StringX, StringX>): Next editing buffer (left and right hand side strings).
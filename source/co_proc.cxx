@@ -0,0 +1,387 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ source file: co_proc.cxx                                                                 ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Include the primary header.
+#include "co_proc.hxx"
+
+// Include the headers of STL.
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <fcntl.h>
+#include <memory>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Environment variables passed to the child processes.
+extern char** environ;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Static variables
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static constexpr uint8_t MAX_QUICK_FAILURES = 3;
+// The plugin which exited this number of times without any response is not restarted until
+// `RESTART_INTERVAL` passes since the last start, so that a broken plugin is not started at
+// every keystroke.
+
+static constexpr std::chrono::seconds RESTART_INTERVAL = std::chrono::seconds(10);
+// Minimum interval to restart a broken plugin.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// CoProc: Constructors and destructors
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+CoProc::CoProc(const String& command, float timeout) : command(command), timeout(timeout), next_id(1), pid(0), fd(-1), n_failures(0)
+{ /* Do nothing */ }
+
+CoProc::~CoProc()
+{   // {{{
+
+    std::lock_guard<std::mutex> lock_start(this->mutex_start);
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    this->stop(lock);
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// CoProc: Member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t CoProc::submit(const Vector<String>& fields) noexcept
+{   // {{{
+
+    std::lock_guard<std::mutex> lock_start(this->mutex_start);
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    const auto now = std::chrono::steady_clock::now();
+
+    // Kill the plugin if the oldest request is not answered within the timeout, including the
+    // cancelled ones, because the plugin answers the requests one by one.
+    const auto deadline = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(this->timeout));
+    const bool hung     = std::any_of(this->pending.begin(), this->pending.end(), [&](const auto& item) noexcept { return now - item.second > deadline; });
+
+    if ((this->pid > 0) and hung)
+        this->stop(lock);
+
+    // (Re)start the plugin if it is not running. The request fails immediately if the plugin
+    // cannot be started.
+    if (this->pid == 0)
+    {
+        this->stop(lock);
+
+        const bool throttled = (this->n_failures >= MAX_QUICK_FAILURES) and (now - this->time_started < RESTART_INTERVAL);
+        if (throttled or (not this->start()))
+        {
+            const uint64_t id = this->next_id++;
+            this->results[id] = "";
+            return id;
+        }
+    }
+
+    const uint64_t id = this->next_id++;
+    this->pending[id] = now;
+
+    // Send the request. The request is never partially written unless the plugin stops reading
+    // its input, which is handled as a hung plugin.
+    String line = std::to_string(id);
+    for (const String& field : fields)
+        line += "\t" + CoProc::escape(field);
+    line += "\n";
+
+    for (size_t pos = 0; pos < line.size();)
+    {
+        const ssize_t n = send(this->fd, line.data() + pos, line.size() - pos, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+        if ((n < 0) and (errno == EINTR))
+            continue;
+
+        // The pending requests are finished by the reader thread when the plugin is killed. The
+        // request is finished here if the plugin already exited and the reader thread finished.
+        if (n <= 0)
+        {
+            if (this->pid > 0)
+                kill(-this->pid, SIGKILL);
+            else if (this->pending.erase(id) > 0)
+                this->results[id] = "";
+
+            break;
+        }
+
+        pos += static_cast<size_t>(n);
+    }
+
+    return id;
+
+}   // }}}
+
+void CoProc::cancel(uint64_t id) noexcept
+{   // {{{
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        // The response of the pending request is discarded when it arrives.
+        if (this->pending.contains(id))
+            this->cancelled.insert(id);
+
+        this->results.erase(id);
+    }
+    this->cond.notify_all();
+
+}   // }}}
+
+bool CoProc::poll(uint64_t id, float timeout, String& output) noexcept
+{   // {{{
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    // Returns true if the request finished or is unknown (e.g. cancelled).
+    const auto predicate = [this, id]() noexcept -> bool
+    { return this->results.contains(id) or this->cancelled.contains(id) or (not this->pending.contains(id)); };
+
+    if (timeout > 0)
+        this->cond.wait_for(lock, std::chrono::duration<float>(timeout), predicate);
+
+    const auto iter = this->results.find(id);
+    if (iter == this->results.end())
+        return false;
+
+    output = std::move(iter->second);
+    this->results.erase(iter);
+
+    return true;
+
+}   // }}}
+
+bool CoProc::finished(uint64_t id) noexcept
+{   // {{{
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    return this->results.contains(id);
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// CoProc: Static functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+String CoProc::escape(const String& str) noexcept
+{   // {{{
+
+    String result;
+    result.reserve(str.size());
+
+    for (const char c : str)
+    {
+        if      (c == '\\') result += "\\\\";
+        else if (c == '\t') result += "\\t";
+        else if (c == '\n') result += "\\n";
+        else                result += c;
+    }
+
+    return result;
+
+}   // }}}
+
+String CoProc::unescape(const String& str) noexcept
+{   // {{{
+
+    String result;
+    result.reserve(str.size());
+
+    for (size_t idx = 0; idx < str.size(); ++idx)
+    {
+        if ((str[idx] != '\\') or (idx + 1 == str.size()))
+        {
+            result += str[idx];
+            continue;
+        }
+
+        const char c = str[++idx];
+
+        if      (c == 't') result += '\t';
+        else if (c == 'n') result += '\n';
+        else               result += c;
+    }
+
+    return result;
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// CoProc: Private member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool CoProc::start(void) noexcept
+{   // {{{
+
+    // Connect both of the standard input and output of the plugin to a socket, which can be
+    // written without SIGPIPE even if the plugin exited.
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+        return false;
+
+    // The plugin runs in a new process group so that its children are also killed.
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+    posix_spawnattr_setpgroup(&attr, 0);
+
+    pid_t child = 0;
+    char* argv[] = {const_cast<char*>("/bin/sh"), const_cast<char*>("-c"), const_cast<char*>(this->command.c_str()), nullptr};
+    const int status = posix_spawn(&child, "/bin/sh", &actions, &attr, argv, environ);
+
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    close(fds[1]);
+
+    this->time_started = std::chrono::steady_clock::now();
+
+    if (status != 0)
+    {
+        close(fds[0]);
+        ++this->n_failures;
+        return false;
+    }
+
+    this->pid    = child;
+    this->fd     = fds[0];
+    this->reader = std::thread(&CoProc::read, this, fds[0], child);
+
+    return true;
+
+}   // }}}
+
+void CoProc::stop(std::unique_lock<std::mutex>& lock) noexcept
+{   // {{{
+
+    // The reader thread finds the end of the output and cleans up. The process ID and the socket
+    // are valid while the process ID is not zero, i.e. before the reader thread reaps it.
+    if (this->pid > 0)
+    {
+        kill(-this->pid, SIGKILL);
+        shutdown(this->fd, SHUT_RDWR);
+    }
+
+    if (this->reader.joinable())
+    {
+        lock.unlock();
+        this->reader.join();
+        lock.lock();
+    }
+
+}   // }}}
+
+void CoProc::read(int fd, pid_t pid) noexcept
+{   // {{{
+
+    // Lines of the responses which are not finished yet.
+    Map<uint64_t, Vector<String>> partial;
+    String buffer;
+    bool   answered = false;
+
+    char chunk[4096];
+    while (true)
+    {
+        const ssize_t n = ::read(fd, chunk, sizeof(chunk));
+
+        if (n < 0 and errno == EINTR) continue;
+        if (n <= 0) break;
+
+        buffer.append(chunk, static_cast<size_t>(n));
+
+        // Process all complete lines.
+        size_t pos_bgn = 0;
+        for (size_t pos_end = buffer.find('\n'); pos_end != String::npos; pos_end = buffer.find('\n', pos_bgn))
+        {
+            const String line    = buffer.substr(pos_bgn, pos_end - pos_bgn);
+            const size_t pos_tab = line.find('\t');
+            const uint64_t id    = std::strtoull(line.c_str(), nullptr, 10);
+            pos_bgn = pos_end + 1;
+
+            if (pos_tab != String::npos)
+            {
+                partial[id].push_back(CoProc::unescape(line.substr(pos_tab + 1)));
+                continue;
+            }
+
+            // End of the response. The responses of the cancelled requests are discarded.
+            String output;
+            for (const String& text : partial[id])
+                output += (output.empty() ? "" : "\n") + text;
+            partial.erase(id);
+            answered = true;
+
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+
+                this->n_failures = 0;
+
+                if ((this->pending.erase(id) > 0) and (this->cancelled.erase(id) == 0))
+                    this->results[id] = std::move(output);
+            }
+            this->cond.notify_all();
+        }
+        buffer.erase(0, pos_bgn);
+    }
+
+    // The plugin exited or was killed. The pending requests are finished with empty responses.
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        for (const auto& [id, time_sent] : this->pending)
+            if (not this->cancelled.contains(id))
+                this->results[id] = "";
+
+        this->pending.clear();
+        this->cancelled.clear();
+
+        if (not answered)
+            ++this->n_failures;
+
+        this->pid = 0;
+        this->fd  = -1;
+    }
+    this->cond.notify_all();
+
+    close(fd);
+
+    while ((waitpid(pid, nullptr, 0) < 0) and (errno == EINTR))
+    { /* Do nothing, just retry if interrupted. */ }
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Published functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+CoProc& get_coproc(const String& command, float timeout) noexcept
+{   // {{{
+
+    static std::mutex                                mutex;
+    static Map<String, std::unique_ptr<CoProc>> coprocs;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::unique_ptr<CoProc>& coproc = coprocs[command];
+    if (coproc == nullptr)
+        coproc = std::make_unique<CoProc>(command, timeout);
+
+    return *coproc;
+
+}   // }}}
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
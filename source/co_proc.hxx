@@ -0,0 +1,191 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ header file: co_proc.hxx                                                                 ///
+///                                                                                              ///
+/// This file defines the class `CoProc` which runs a plugin (e.g. a completion helper written   ///
+/// in Python) as a persistent coprocess, so that the plugin is started once and each query      ///
+/// costs a round trip instead of a process launch. The requests are written to the standard     ///
+/// input of the plugin, and the responses are read from its standard output, where both are     ///
+/// lines of tab-separated values:                                                               ///
+///                                                                                              ///
+///   request : <id> TAB <field> TAB <field> ... LF                                              ///
+///   response: <id> TAB <line> LF (zero or more) followed by <id> LF                            ///
+///                                                                                              ///
+/// The backslash, TAB and LF in the fields and lines are escaped as "\\", "\t", and "\n". The   ///
+/// responses of the cancelled requests are discarded. A plugin which exits is restarted at the  ///
+/// next request, and a plugin which does not answer within the timeout is killed.               ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CO_PROC_HXX
+#define CO_PROC_HXX
+
+// Include the headers of STL.
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <sys/types.h>
+#include <thread>
+
+// Include the headers of custom modules.
+#include "dtypes.hxx"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Class definitions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class CoProc
+{
+    public:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Constructors and destructors
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+         CoProc(const String& command, float timeout);
+        ~CoProc();
+        // [Abstract]
+        //   Constructor and destructor of CoProc. The plugin is started at the first request, and
+        //   is killed by the destructor.
+        //
+        // [Args]
+        //   command (const String&): [IN] Shell command to start the plugin.
+        //   timeout (float)        : [IN] The plugin is killed if a request is not answered within
+        //                                 this time in seconds.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        uint64_t submit(const Vector<String>& fields) noexcept;
+        // [Abstract]
+        //   Send a request to the plugin. This function returns immediately. The plugin is
+        //   (re)started if it is not running.
+        //
+        // [Args]
+        //   fields (const Vector<String>&): [IN] Fields of the request.
+        //
+        // [Returns]
+        //   (uint64_t): ID of the request (IDs increase monotonically and never be zero).
+
+        void cancel(uint64_t id) noexcept;
+        // [Abstract]
+        //   Cancel the given request. The response will be discarded.
+        //
+        // [Args]
+        //   id (uint64_t): [IN] ID of the request.
+
+        bool poll(uint64_t id, float timeout, String& output) noexcept;
+        // [Abstract]
+        //   Get the response of the given request if finished. The response can be obtained only
+        //   once. The response of a request is empty if the plugin exited or was killed.
+        //
+        // [Args]
+        //   id      (uint64_t): [IN ] ID of the request.
+        //   timeout (float)   : [IN ] Maximum time to wait for the response in seconds.
+        //   output  (String&) : [OUT] Lines of the response separated by LF.
+        //
+        // [Returns]
+        //   (bool): True if the request finished and the response is stored.
+
+        bool finished(uint64_t id) noexcept;
+        // [Abstract]
+        //   Returns true if the given request finished (i.e. `poll` will return immediately).
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Static functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        static String escape(const String& str) noexcept;
+        // [Abstract]
+        //   Escape the backslash, TAB, and LF in the string.
+
+        static String unescape(const String& str) noexcept;
+        // [Abstract]
+        //   Restore the escaped string.
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member variables
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        String command;
+        // Shell command to start the plugin.
+
+        float timeout;
+        // Maximum time to answer a request in seconds.
+
+        uint64_t next_id;
+        // ID of the next request.
+
+        pid_t pid;
+        // Process ID of the plugin (zero if not running).
+
+        int fd;
+        // Socket connected to the standard input and output of the plugin.
+
+        uint8_t n_failures;
+        // Number of the consecutive exits of the plugin without any response.
+
+        std::chrono::steady_clock::time_point time_started;
+        // Time when the plugin was started last.
+
+        Map<uint64_t, std::chrono::steady_clock::time_point> pending;
+        // Requests waiting for the response and the time when they are sent.
+
+        Set<uint64_t> cancelled;
+        // Pending requests which are cancelled (the plugin may be still working on them).
+
+        Map<uint64_t, String> results;
+        // Responses of the finished requests.
+
+        std::mutex mutex;
+        // Mutex for the member variables above.
+
+        std::mutex mutex_start;
+        // Mutex to (re)start the plugin and its reader thread.
+
+        std::condition_variable cond;
+        // Condition variable to notify finished requests.
+
+        std::thread reader;
+        // Thread which reads the responses of the running plugin.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        bool start(void) noexcept;
+        // [Abstract]
+        //   Start the plugin and its reader thread. The mutex should be locked.
+
+        void stop(std::unique_lock<std::mutex>& lock) noexcept;
+        // [Abstract]
+        //   Kill the plugin and wait for its reader thread. The mutex is unlocked while waiting.
+
+        void read(int fd, pid_t pid) noexcept;
+        // [Abstract]
+        //   Main loop of the reader thread. The pending requests are finished with empty
+        //   responses when the plugin exits.
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Published functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+CoProc& get_coproc(const String& command, float timeout) noexcept;
+// [Abstract]
+//   Returns the coprocess of the plugin which is shared during the session. This function is
+//   thread-safe.
+//
+// [Args]
+//   command (const String&): [IN] Shell command to start the plugin.
+//   timeout (float)        : [IN] Maximum time to answer a request in seconds (used only when
+//                                 the coprocess is created).
+//
+// [Returns]
+//   (CoProc&): Coprocess of the plugin.
+
+#endif
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
@@ -0,0 +1,206 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ source file: comp_rules.cxx                                                              ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Include the primary header.
+#include "comp_rules.hxx"
+
+// Include the headers of STL.
+#include <algorithm>
+
+// Include the headers of custom modules.
+#include "file_stat.hxx"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Static functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static bool is_literal(const String& str) noexcept
+// [Abstract]
+//   Returns true if the given string contains no special character of regular expressions.
+//
+// [Args]
+//   str (const String&): [IN] Target string.
+//
+// [Returns]
+//   (bool): True if the string is a literal.
+//
+{   // {{{
+
+    return str.find_first_of(".[]{}()*+?^$|\\") == String::npos;
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// CompRules: Constructors
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+CompRules::CompRules(const Vector<Rule>& rules)
+{   // {{{
+
+    for (const Rule& source : rules)
+    {
+        Compiled rule = {{}, {}, false, source};
+
+        // Compile the patterns, where the patterns after ">>" are stored separately because they
+        // are matched with the last tokens.
+        for (const String& pattern : source.patterns)
+        {
+            if      (pattern == ">>") rule.skip = true;
+            else if (rule.skip)       rule.tail.push_back(CompRules::compile(pattern));
+            else                      rule.head.push_back(CompRules::compile(pattern));
+        }
+
+        // Register the rule to the dispatch table.
+        const uint32_t index = static_cast<uint32_t>(this->rules.size());
+        if ((rule.head.size() > 0) and (rule.head[0].kind == Kind::LITERAL))
+            this->by_command[rule.head[0].text].push_back(index);
+        else
+            this->generic.push_back(index);
+
+        this->rules.push_back(std::move(rule));
+    }
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// CompRules: Member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Tuple<EditHelper::CompType, String> CompRules::find(const Vector<String>& tokens) const noexcept
+{   // {{{
+
+    const Rule* rule = this->find_rule(tokens);
+
+    if (rule == nullptr)
+        return {EditHelper::CompType::NONE, String("")};
+
+    return {rule->type, rule->option};
+
+}   // }}}
+
+const CompRules::Rule* CompRules::find_rule(const Vector<String>& tokens) const noexcept
+{   // {{{
+
+    static const Vector<uint32_t> empty;
+
+    // Get the rules dispatched by the first token. The other rules are always candidates.
+    const auto iter = (tokens.size() > 0) ? this->by_command.find(tokens[0]) : this->by_command.end();
+    const Vector<uint32_t>& specific = (iter != this->by_command.end()) ? iter->second : empty;
+
+    // Merge the two sorted lists of rule indices to keep the priority of rules.
+    auto iter_s = specific.begin();
+    auto iter_g = this->generic.begin();
+
+    while ((iter_s != specific.end()) or (iter_g != this->generic.end()))
+    {
+        const bool use_s = (iter_g == this->generic.end()) or ((iter_s != specific.end()) and (*iter_s < *iter_g));
+        const Compiled& rule = this->rules[use_s ? *(iter_s++) : *(iter_g++)];
+
+        if (this->match(rule, tokens))
+            return &rule.rule;
+    }
+
+    return nullptr;
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// CompRules: Private member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool CompRules::match(const Compiled& rule, const Vector<String>& tokens) const noexcept
+{   // {{{
+
+    const size_t n_tokens = tokens.size();
+    const size_t n_head   = rule.head.size();
+    const size_t n_tail   = rule.tail.size();
+
+    // Resolve which token is matched with each pattern. Without ">>", the number of tokens must
+    // equal to the number of patterns. With ">>", at least one token should remain after the
+    // head patterns, and the tail patterns are matched with the last tokens.
+    if ((not rule.skip) and (n_tokens != n_head))                    return false;
+    if (rule.skip and ((n_tokens <= n_head) or (n_tokens < n_tail))) return false;
+
+    const size_t offset_tail = n_tokens - n_tail;
+
+    // Match the patterns except "FILE" at first, and then check the existence of the files.
+    for (bool check_file : {false, true})
+    {
+        for (size_t idx = 0; idx < n_head; ++idx)
+            if (not CompRules::match(rule.head[idx], tokens[idx], check_file))
+                return false;
+
+        for (size_t idx = 0; idx < n_tail; ++idx)
+            if (not CompRules::match(rule.tail[idx], tokens[offset_tail + idx], check_file))
+                return false;
+    }
+
+    return true;
+
+}   // }}}
+
+CompRules::Matcher CompRules::compile(const String& pattern) noexcept
+{   // {{{
+
+    Matcher matcher = {Kind::REGEX, "", {}, {}};
+
+    // Special patterns.
+    if      (pattern == "FILE") matcher.kind = Kind::FILE;
+    else if (pattern == ".*"  ) matcher.kind = Kind::ANY;
+    else if (pattern == ".+"  ) matcher.kind = Kind::NONEMPTY;
+
+    // Literal string, e.g. "git".
+    else if (is_literal(pattern))
+    {
+        matcher.kind = Kind::LITERAL;
+        matcher.text = pattern;
+    }
+
+    // Literal prefix, e.g. "-.*".
+    else if (pattern.ends_with(".*") and is_literal(pattern.substr(0, pattern.size() - 2)))
+    {
+        matcher.kind = Kind::PREFIX;
+        matcher.text = pattern.substr(0, pattern.size() - 2);
+    }
+
+    // Character set of the first character, e.g. "[./~].*".
+    else if (pattern.starts_with('[') and pattern.ends_with("].*") and (pattern.size() > 4) and
+             (pattern.find_first_of("[]^\\", 1) == pattern.size() - 3) and
+             (pattern.substr(2, pattern.size() - 6).find('-') == String::npos))
+    {
+        matcher.kind = Kind::CHARSET;
+        for (size_t idx = 1; idx < pattern.size() - 3; ++idx)
+            matcher.chars.set(static_cast<uint8_t>(pattern[idx]));
+    }
+
+    // Otherwise use regular expression. Invalid patterns never match.
+    else
+    {
+        try                             { matcher.regex = std::regex(pattern, std::regex::optimize); }
+        catch (const std::regex_error&) { matcher.regex = std::regex("(?!)");                        }
+    }
+
+    return matcher;
+
+}   // }}}
+
+bool CompRules::match(const Matcher& matcher, const String& token, bool check_file) noexcept
+{   // {{{
+
+    switch (matcher.kind)
+    {
+        case Kind::ANY     : return true;
+        case Kind::NONEMPTY: return check_file or (token.size() > 0);
+        case Kind::LITERAL : return check_file or (token == matcher.text);
+        case Kind::PREFIX  : return check_file or token.starts_with(matcher.text);
+        case Kind::CHARSET : return check_file or ((token.size() > 0) and matcher.chars.test(static_cast<uint8_t>(token[0])));
+        case Kind::FILE    : return (not check_file) or get_file_stat(token).exists;
+        case Kind::REGEX   : return check_file or std::regex_match(token, matcher.regex);
+    }
+
+    return false;
+
+}   // }}}
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
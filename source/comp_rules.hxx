@@ -0,0 +1,153 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ header file: comp_rules.hxx                                                              ///
+///                                                                                              ///
+/// This file defines the class `CompRules` which selects the completion type from the parsed    ///
+/// tokens. The completion table is compiled once; each pattern is classified into a literal,    ///
+/// prefix, or character set matcher if possible (otherwise a precompiled regular expression),   ///
+/// and the rules are dispatched by the first token.                                             ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef COMP_RULES_HXX
+#define COMP_RULES_HXX
+
+// Include the headers of STL.
+#include <bitset>
+#include <regex>
+
+// Include the headers of custom modules.
+#include "dtypes.hxx"
+#include "edit_helper.hxx"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Class definitions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class CompRules
+{
+    public:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Data types
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        typedef struct Rule
+        {
+            Vector<String>       patterns;    // Patterns of the tokens.
+            EditHelper::CompType type;        // Completion type.
+            String               option;      // Optional string (e.g. shell command of SHELL).
+            float                ttl   = 0;   // Time-to-live of the cached output of SHELL in seconds.
+            Vector<String>       watch = {};  // Files whose modification invalidates the cached output.
+        }
+        Rule;
+        // Completion rule. See `config.completions` for details.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Constructors and destructors
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        explicit CompRules(const Vector<Rule>& rules);
+        // [Abstract]
+        //   Constructor of CompRules. All patterns of the given rules are compiled.
+        //
+        // [Args]
+        //   rules (const Vector<Rule>&): [IN] Completion rules in order of priority.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        Tuple<EditHelper::CompType, String> find(const Vector<String>& tokens) const noexcept;
+        // [Abstract]
+        //   Find the first rule which matches with the given tokens. The patterns of a rule are
+        //   matched with the tokens one by one, except that the special pattern ">>" skips tokens
+        //   so that the patterns after it are matched with the last tokens, and the special
+        //   pattern "FILE" matches with an existing file path.
+        //
+        // [Args]
+        //   tokens (const Vector<String>&): [IN] Tokens of the user input (white-spaces dropped).
+        //
+        // [Returns]
+        //   (Tuple<EditHelper::CompType, String>): Completion type and its optional string
+        //                                          (CompType::NONE if no rule matched).
+
+        const Rule* find_rule(const Vector<String>& tokens) const noexcept;
+        // [Abstract]
+        //   Same as `find`, but returns the matched rule itself.
+        //
+        // [Args]
+        //   tokens (const Vector<String>&): [IN] Tokens of the user input (white-spaces dropped).
+        //
+        // [Returns]
+        //   (const Rule*): Matched rule (nullptr if no rule matched).
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Data types
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        enum class Kind { ANY, NONEMPTY, LITERAL, PREFIX, CHARSET, FILE, REGEX };
+        // Kind of the compiled pattern.
+        //   * ANY     : Matches any token (".*").
+        //   * NONEMPTY: Matches any non-empty token (".+").
+        //   * LITERAL : Matches the literal string (e.g. "git").
+        //   * PREFIX  : Matches the tokens which start with the literal string (e.g. "-.*").
+        //   * CHARSET : Matches the tokens which start with one of the characters (e.g. "[./~].*").
+        //   * FILE    : Matches existing file paths ("FILE").
+        //   * REGEX   : Matches the precompiled regular expression (others).
+
+        typedef struct Matcher
+        {
+            Kind             kind;   // Kind of the pattern.
+            String           text;   // Literal string or prefix.
+            std::bitset<256> chars;  // Character set of the first character.
+            std::regex       regex;  // Precompiled regular expression.
+        }
+        Matcher;
+        // Compiled pattern.
+
+        typedef struct Compiled
+        {
+            Vector<Matcher> head;  // Patterns before ">>".
+            Vector<Matcher> tail;  // Patterns after ">>".
+            bool            skip;  // True if the rule has ">>".
+            Rule            rule;  // Source of the compiled rule.
+        }
+        Compiled;
+        // Compiled rule.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member variables
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        Vector<Compiled> rules;
+        // Compiled rules in order of priority.
+
+        Map<String, Vector<uint32_t>> by_command;
+        // Indices of the rules whose first pattern is a literal, grouped by the literal.
+
+        Vector<uint32_t> generic;
+        // Indices of the other rules.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        bool match(const Compiled& rule, const Vector<String>& tokens) const noexcept;
+        // [Abstract]
+        //   Returns true if the given tokens match with the rule.
+
+        static Matcher compile(const String& pattern) noexcept;
+        // [Abstract]
+        //   Compile the given pattern.
+
+        static bool match(const Matcher& matcher, const String& token, bool check_file) noexcept;
+        // [Abstract]
+        //   Returns true if the given token matches with the pattern. The "FILE" pattern always
+        //   matches if `check_file` is false, so that the costly file system access is done only
+        //   after the other patterns of the rule matched.
+};
+
+#endif
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
@@ -8,8 +8,10 @@
 #define CONFIG_HXX
 
 // Include the headers of custom modules.
+#include "comp_rules.hxx"
 #include "dtypes.hxx"
 #include "edit_helper.hxx"
+#include "hist_writer.hxx"
 #include "string_x.hxx"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -34,6 +36,12 @@ typedef struct NiShiKiConfig
     // Path to history file.
     const char* path_history = "~/.local/share/nishiki/history.txt";
 
+    // Path to binary history log which stores histories with metadata.
+    const char* path_histlog = "~/.local/share/nishiki/history.bin";
+
+    // Path to the cache file of the command options parsed from "--help".
+    const char* path_optcache = "~/.cache/nishiki/options.txt";
+
     // Path to plugin directory.
     const char* path_plugins = "~/.config/nishiki/plugins";
 
@@ -41,6 +49,10 @@ typedef struct NiShiKiConfig
     const char* datetime_pre = "\x1B[38;2;112;120;128m[";
     const char* datetime_post = "]\x1B[0m";
 
+    // Prefix and postfix strings of the indicator of the hidden completion candidates.
+    const char* pager_pre = "\x1B[38;2;112;120;128m";
+    const char* pager_post = "\x1B[0m";
+
     // Prefix and postfix strings of the command history completions.
     const char* histhint_pre = "\x1B[38;2;112;120;128m";
     const char* histhint_post = "\x1B[0m";
@@ -49,9 +61,85 @@ typedef struct NiShiKiConfig
     const char* horizontal_line_char = "⎯";
     const char* horizontal_line_color = "\x1B[38;2;112;120;128m";
 
+    // Half-life of the score of history completion in number of commands. Each use of a command
+    // adds weight to its score, and the weight of old uses decays with this half-life.
+    float histhint_half_life = 100;
+
+    // The score of history completion is divided by this value if the command failed last time.
+    float histhint_failure_penalty = 4;
+
+    // Prompt strings of the fuzzy history search (Ctrl-U) and the substring history search
+    // (Ctrl-R), and the prefix and postfix strings of the matched characters in the results.
+    const char* histsearch_prompt = "\x1B[38;2;112;120;128m(history)\x1B[0m ";
+    const char* histsearch_prompt_substr = "\x1B[38;2;112;120;128m(reverse-i-search)\x1B[0m ";
+    const char* histsearch_match_pre = "\x1B[1;33m";
+    const char* histsearch_match_post = "\x1B[22;39m";
+
+    // Maximum number of results of the fuzzy history search.
+    uint16_t histsearch_max_results = 1000;
+
+    // Time-to-live of the cached file metadata used by the completion and preview in seconds.
+    // After that, the cached metadata is revalidated by the modification time of the parent
+    // directory, and is read again at least every `stat_cache_max_age` seconds.
+    float stat_cache_ttl = 1.0;
+    float stat_cache_max_age = 30.0;
+
+    // Number of worker threads which run the shell commands of completion providers (e.g. SHELL),
+    // and the maximum time in seconds to wait for them when the completion is requested by TAB.
+    // The real-time completion never waits for the providers.
+    uint8_t provider_workers = 2;
+    float provider_timeout = 5.0;
+
+    // Maximum time in seconds to answer a request by a plugin (see PLUGIN and `preview_plugins`).
+    // The plugin which does not answer within this time is killed and restarted at the next
+    // request.
+    float plugin_timeout = 1.0;
+
+    // Number of the most frequent commands in the histories whose options are parsed in advance.
+    uint16_t optcache_warm_commands = 16;
+
     // Enables real-time completion if true.
     bool realtime_completion = false;
 
+    // Maximum number of completion candidates which can be browsed by PageUp/PageDown.
+    uint32_t completion_max_cands = 10000;
+
+    // Enables fuzzy completion if true. The candidates of commands, paths, options, and sub
+    // commands contain the query as a subsequence (e.g. "gco" matches "git-checkout"), ordered
+    // by the score of the fuzzy history search, and the matched characters are decorated with
+    // the prefix and postfix strings (they should not reset the color of the candidates).
+    bool fuzzy_completion = false;
+    const char* fuzzy_match_pre = "\x1B[1;4m";
+    const char* fuzzy_match_post = "\x1B[22;24m";
+
+    // Number of worker threads, maximum depth, and maximum number of entries of the directory
+    // walker of the recursive path completion, e.g. "src/**/main" completes the paths under
+    // "src" which have a component starting with "main". Hidden directories and the entries
+    // ignored by ".gitignore" are not listed.
+    uint8_t  walker_workers     = 4;
+    uint16_t walker_max_depth   = 16;
+    uint32_t walker_max_entries = 200000;
+
+    // Complete the paths in a git work tree from the files tracked in the git index if true, so
+    // that build outputs and ignored files are not listed. The directories which have no tracked
+    // file are listed from the file system. The entries of the directory which are not tracked
+    // (e.g. new files) are also listed if `git_completion_untracked` is true.
+    bool git_completion = false;
+    bool git_completion_untracked = false;
+
+    // Share histories between multiple NiShiKi sessions if true.
+    // The histories written by the other sessions are read at every prompt.
+    bool share_history = false;
+
+    // Durability policy of the history files that are written on a background thread.
+    //   * NONE    : Never call fdatasync (fastest, data is flushed by the OS).
+    //   * BATCH   : Call fdatasync after writing each batch of histories.
+    //   * INTERVAL: Call fdatasync at every `history_sync_interval` seconds.
+    HistWriter::Durability history_durability = HistWriter::Durability::NONE;
+
+    // Interval of fdatasync in seconds (used only if the durability policy is INTERVAL).
+    uint16_t history_sync_interval = 5;
+
     ////////////////////////////////////////////////////////////////////////////
     // Prompt strings.
     ////////////////////////////////////////////////////////////////////////////
@@ -101,7 +189,6 @@ typedef struct NiShiKiConfig
     // For example, Ctrl-A=0x01, Ctrl-B=0x02, ..., Ctrl-Z=0x1A.
     Map<uint64_t, String> keybinds = {
         {0x06, "!chooser --lhs '{lhs}' --rhs '{rhs}' --mode file "},              // Ctrl-F
-        {0x15, "!chooser --lhs '{lhs}' --rhs '{rhs}' --mode hist --hist {hist}"}, // Ctrl-U
         {0x10, "!chooser --lhs '{lhs}' --rhs '{rhs}' --mode proc "},              // Ctrl-P
         {0x16, "!ext_cmd --lhs '{lhs}' --rhs '{rhs}' --cmd 'xclip -o'"},          // Ctrl-V
         {0x0C, "clear"},                                                          // Ctrl-L
@@ -120,22 +207,35 @@ typedef struct NiShiKiConfig
     // Completion settings.
     ////////////////////////////////////////////////////////////////////////////
 
-    Vector<Tuple<Vector<String>, EditHelper::CompType, String>> completions = {
+    // Each rule is a tuple of the patterns of tokens, completion type, and optional string.
+    // The output of the shell command of SHELL is cached for each working directory during the
+    // optional TTL in seconds, unless one of the optional watched files is modified. Relative
+    // paths of the watched files are searched from the working directory to the root directory.
+    // The optional string of PLUGIN is a shell command which starts a plugin. The plugin is
+    // started once and keeps running, reads requests "<id> TAB complete TAB <cwd> TAB <token>..."
+    // line by line from the standard input, and writes lines "<id> TAB <candidate>[ TAB <desc>]"
+    // followed by a line "<id>" to the standard output (see co_proc.hxx for the details). If the
+    // plugin answers nothing, the candidates are computed as PATH (or OPTION). For example, the
+    // rule {{">>", ".*"}, EditHelper::CompType::PLUGIN, "~/.config/nishiki/plugins/compgen"}
+    // placed before the low priority rules completes the commands which have no rule by the
+    // completion specs of bash-completion, where the "compgen" plugin keeps a bash process which
+    // loads bash-completion only once.
+    Vector<CompRules::Rule> completions = {
 
         // Docker command completions.
-        {{"docker", "exec", ">>", ".*"}, EditHelper::CompType::SHELL,  "docker container ls -a --format '{{.Names}}'"},
-        {{"docker", "run",  ">>", ".*"}, EditHelper::CompType::SHELL,  "docker image ls --format '{{.Repository}}:{{.Tag}}'"},
+        {{"docker", "exec", ">>", ".*"}, EditHelper::CompType::SHELL,  "docker container ls -a --format '{{.Names}}'", 2},
+        {{"docker", "run",  ">>", ".*"}, EditHelper::CompType::SHELL,  "docker image ls --format '{{.Repository}}:{{.Tag}}'", 10},
         {{"docker", ".*"},               EditHelper::CompType::SUBCMD, "docker --help | grep -E '^  [^ -]'"},
 
         // Git command completions.
-        {{"git", "branch",   ">>", ".*"}, EditHelper::CompType::SHELL,  "git branch -a --no-color | cut -b 3- | cut -d ' ' -f 1"},
-        {{"git", "checkout", ">>", ".*"}, EditHelper::CompType::SHELL,  "git branch -a --no-color | cut -b 3- | cut -d ' ' -f 1"},
-        {{"git", "merge",    ">>", ".*"}, EditHelper::CompType::SHELL,  "git branch -a --no-color | cut -b 3- | cut -d ' ' -f 1"},
-        {{"git", "push",     ">>", ".*"}, EditHelper::CompType::SHELL,  "git branch -a --no-color | cut -b 3- | cut -d ' ' -f 1"},
+        {{"git", "branch",   ">>", ".*"}, EditHelper::CompType::SHELL,  "git branch -a --no-color | cut -b 3- | cut -d ' ' -f 1", 60, {".git/HEAD", ".git/refs/heads", ".git/packed-refs"}},
+        {{"git", "checkout", ">>", ".*"}, EditHelper::CompType::SHELL,  "git branch -a --no-color | cut -b 3- | cut -d ' ' -f 1", 60, {".git/HEAD", ".git/refs/heads", ".git/packed-refs"}},
+        {{"git", "merge",    ">>", ".*"}, EditHelper::CompType::SHELL,  "git branch -a --no-color | cut -b 3- | cut -d ' ' -f 1", 60, {".git/HEAD", ".git/refs/heads", ".git/packed-refs"}},
+        {{"git", "push",     ">>", ".*"}, EditHelper::CompType::SHELL,  "git branch -a --no-color | cut -b 3- | cut -d ' ' -f 1", 60, {".git/HEAD", ".git/refs/heads", ".git/packed-refs"}},
         {{"git", ".*"},                   EditHelper::CompType::SUBCMD, "git --help | grep -E '^   [^ ]'"},
 
         // Ssh command completions.
-        {{"ssh", ".*"}, EditHelper::CompType::SHELL, "cat ~/.ssh/config 2>/dev/null | grep '^Host ' 2>/dev/null | cut -b 6-"},
+        {{"ssh", ".*"}, EditHelper::CompType::SHELL, "cat ~/.ssh/config 2>/dev/null | grep '^Host ' 2>/dev/null | cut -b 6-", 600, {"~/.ssh/config"}},
 
         // Low priority completions.
         {{"[./~].*"},        EditHelper::CompType::PATH,    ""},
@@ -173,6 +273,11 @@ typedef struct NiShiKiConfig
         {".*/zip",             "timeout 0.1s zipinfo '{path}'"},
     };
 
+    // Collection of MIME type and the plugin command which previews the file. The plugins are
+    // preferred to `previews`. A plugin keeps running like PLUGIN of the completions, and reads
+    // requests "<id> TAB preview TAB <path> TAB <mime> TAB <width> TAB <height>".
+    Vector<Pair<String, String>> preview_plugins = {};
+
     // Delimiter of the preview window.
     String preview_delim = " │ ";
 
@@ -0,0 +1,400 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ source file: dir_cache.cxx                                                               ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Include the primary header.
+#include "dir_cache.hxx"
+
+// Include the headers of STL.
+#include <algorithm>
+#include <chrono>
+#include <dirent.h>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Include the headers of custom modules.
+#include "config.hxx"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Static variables
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef struct Scan
+{
+    String           arena;  // Null-separated names of the entries (directories have a trailing slash).
+    Vector<uint32_t> dirs;   // Offsets of the names of the directories in the arena.
+    Vector<uint32_t> files;  // Offsets of the names of the other files in the arena.
+}
+Scan;
+// Result of a directory scan. The names are stored in one flat buffer to avoid an allocation
+// for each entry.
+
+typedef struct Listing
+{
+    Scan    scan;       // Entries of the directory sorted by name (empty if `huge` is true).
+    bool    huge;       // True if the directory has too many entries to be cached.
+    int64_t mtime;      // Modification time of the directory when it was read.
+    int64_t time_read;  // Wall-clock time when the directory was read (nanoseconds).
+    std::chrono::steady_clock::time_point time_checked;  // Time when the listing was validated.
+}
+Listing;
+// Cached listing of a directory.
+
+static constexpr size_t MAX_CACHED_DIRS = 64;
+// The maximum number of cached directories. The least recently validated one is dropped first.
+
+static constexpr size_t MAX_CACHED_ENTRIES = 1 << 18;
+// The maximum number of entries of a cached directory. Larger directories are not cached
+// but scanned with the prefix filter every time, and only the listed entries are sorted.
+
+static constexpr size_t SCAN_BUFFER_SIZE = 1 << 16;
+// Size of the buffer for the getdents64 system call.
+
+static Map<String, std::shared_ptr<Listing>> cache;
+// Cache of the directory listings where the key is the directory path.
+
+static std::mutex cache_mutex;
+// Mutex for the cache.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Static functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static int64_t now_ns(void) noexcept
+// [Abstract]
+//   Returns the current wall-clock time in nanoseconds since the epoch.
+//
+{   // {{{
+
+    const auto now = std::chrono::system_clock::now().time_since_epoch();
+
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+
+}   // }}}
+
+static bool read_mtime(const String& dir, int64_t* mtime) noexcept
+// [Abstract]
+//   Read the modification time of the given directory.
+//
+// [Args]
+//   dir   (const String&): [IN ] Path to the target directory.
+//   mtime (int64_t*)     : [OUT] Modification time in nanoseconds since the epoch.
+//
+// [Returns]
+//   (bool): True if the directory exists.
+//
+{   // {{{
+
+    struct stat st;
+
+    if ((::stat(dir.c_str(), &st) != 0) or (not S_ISDIR(st.st_mode)))
+        return false;
+
+    *mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+
+    return true;
+
+}   // }}}
+
+static bool scan_directory(const String& dir, const String& prefix, bool show_dot, size_t n_max_entries, Scan* scan) noexcept
+// [Abstract]
+//   Scan the entries of the given directory by the getdents64 system call. The entry types are
+//   taken from `d_type`, and the file is stat-ed only if the type is a symbolic link or unknown.
+//   The entries are filtered by the prefix during the scan, and are not sorted.
+//
+// [Args]
+//   dir           (const String&): [IN ] Path to the target directory.
+//   prefix        (const String&): [IN ] Prefix of the names to be scanned.
+//   show_dot      (bool)         : [IN ] Scan dot files if true.
+//   n_max_entries (size_t)       : [IN ] Stop scanning if the number of entries exceeds this value.
+//   scan          (Scan*)        : [OUT] Result of the scan.
+//
+// [Returns]
+//   (bool): False if the directory cannot be read or has too many entries.
+//
+{   // {{{
+
+    // Layout of the records returned by getdents64.
+    struct Dirent64
+    {
+        ino64_t        d_ino;
+        off64_t        d_off;
+        unsigned short d_reclen;
+        unsigned char  d_type;
+        char           d_name[];
+    };
+
+    const int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    static thread_local Vector<char> buffer(SCAN_BUFFER_SIZE);
+
+    bool succeeded = true;
+
+    while (succeeded)
+    {
+        const long n_bytes = ::syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+        if (n_bytes <= 0)
+        {
+            succeeded = (n_bytes == 0);
+            break;
+        }
+
+        for (long pos = 0; pos < n_bytes;)
+        {
+            const Dirent64* entry = reinterpret_cast<const Dirent64*>(buffer.data() + pos);
+            pos += entry->d_reclen;
+
+            const std::string_view name(entry->d_name);
+
+            // Skip the special entries and the entries which does not match with the prefix.
+            if ((name == ".") or (name == "..") or (not name.starts_with(prefix)) or ((not show_dot) and (name[0] == '.')))
+                continue;
+
+            // Follow symbolic links and resolve unknown types by stat, like `is_directory`.
+            bool is_dir = (entry->d_type == DT_DIR);
+            if ((entry->d_type == DT_LNK) or (entry->d_type == DT_UNKNOWN))
+            {
+                struct stat st;
+                is_dir = (::fstatat(fd, entry->d_name, &st, 0) == 0) and S_ISDIR(st.st_mode);
+            }
+
+            (is_dir ? scan->dirs : scan->files).push_back(static_cast<uint32_t>(scan->arena.size()));
+            scan->arena.append(name);
+            scan->arena.append(is_dir ? "/" : "");
+            scan->arena.push_back('\0');
+
+            if (scan->dirs.size() + scan->files.size() > n_max_entries)
+            {
+                succeeded = false;
+                break;
+            }
+        }
+    }
+
+    ::close(fd);
+
+    return succeeded;
+
+}   // }}}
+
+static std::string_view get_name(const Scan& scan, uint32_t offset) noexcept
+// [Abstract]
+//   Returns the name of the entry at the given offset of the arena.
+//
+{   // {{{
+
+    return std::string_view(scan.arena.data() + offset);
+
+}   // }}}
+
+static void sort_entries(const Scan& scan, Vector<uint32_t>& offsets, size_t n_top) noexcept
+// [Abstract]
+//   Sort the first `n_top` entries of the given offsets by name.
+//
+// [Args]
+//   scan    (const Scan&)      : [IN ] Result of the scan.
+//   offsets (Vector<uint32_t>&): [I/O] Offsets of the entries.
+//   n_top   (size_t)           : [IN ] Number of entries to be sorted.
+//
+{   // {{{
+
+    const auto compare = [&scan](uint32_t a, uint32_t b) noexcept -> bool
+    { return get_name(scan, a) < get_name(scan, b); };
+
+    if (n_top >= offsets.size()) std::sort(offsets.begin(), offsets.end(), compare);
+    else                         std::partial_sort(offsets.begin(), offsets.begin() + n_top, offsets.end(), compare);
+
+}   // }}}
+
+static std::shared_ptr<Listing> read_listing(const String& dir, int64_t mtime) noexcept
+// [Abstract]
+//   Read all entries of the given directory and sort them.
+//
+// [Args]
+//   dir   (const String&): [IN] Path to the target directory.
+//   mtime (int64_t)      : [IN] Modification time of the directory.
+//
+// [Returns]
+//   (std::shared_ptr<Listing>): Listing of the directory.
+//
+{   // {{{
+
+    auto listing = std::make_shared<Listing>(Listing{{}, false, mtime, now_ns(), std::chrono::steady_clock::now()});
+
+    // Keep only a marker for huge directories.
+    if (not scan_directory(dir, "", true, MAX_CACHED_ENTRIES, &listing->scan))
+    {
+        listing->scan = Scan();
+        listing->huge = true;
+        return listing;
+    }
+
+    sort_entries(listing->scan, listing->scan.dirs,  listing->scan.dirs.size());
+    sort_entries(listing->scan, listing->scan.files, listing->scan.files.size());
+
+    return listing;
+
+}   // }}}
+
+static std::shared_ptr<Listing> get_listing(const String& dir) noexcept
+// [Abstract]
+//   Get the listing of the given directory from the cache, or read it if not cached or stale.
+//
+// [Args]
+//   dir (const String&): [IN] Path to the target directory.
+//
+// [Returns]
+//   (std::shared_ptr<Listing>): Listing of the directory (nullptr if not a directory).
+//
+{   // {{{
+
+    using seconds = std::chrono::duration<double>;
+
+    const auto now = std::chrono::steady_clock::now();
+
+    std::shared_ptr<Listing> cached;
+
+    // Case 1: the listing was validated recently => use it without any system call.
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+
+        const auto iter = cache.find(dir);
+        if (iter != cache.end())
+            cached = iter->second;
+
+        if (cached and (seconds(now - cached->time_checked).count() < config.stat_cache_ttl))
+            return cached;
+    }
+
+    int64_t mtime = 0;
+    if (not read_mtime(dir, &mtime))
+        return nullptr;
+
+    // Case 2: the directory is not modified => the listing is still valid. The listing is trusted
+    // only if it was read well after the modification because the time stamps of some file systems
+    // are coarse (at most one second).
+    if (cached and (cached->mtime == mtime) and (cached->time_read - mtime > 1000000000))
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        cached->time_checked = now;
+        return cached;
+    }
+
+    // Case 3: otherwise, read the directory again. The directory is read without the lock
+    // because it can take long time for huge directories.
+    std::shared_ptr<Listing> listing = read_listing(dir, mtime);
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+
+    cache[dir] = listing;
+
+    // Drop the least recently validated listing if too many directories are cached.
+    if (cache.size() > MAX_CACHED_DIRS)
+    {
+        constexpr auto compare = [](const auto& a, const auto& b) noexcept -> bool
+        { return a.second->time_checked < b.second->time_checked; };
+
+        cache.erase(std::min_element(cache.begin(), cache.end(), compare));
+    }
+
+    return listing;
+
+}   // }}}
+
+static void scan_range(Vector<String>& result, const Scan& scan, const Vector<uint32_t>& offsets, const String& prefix, uint32_t n_max_items, bool show_dot) noexcept
+// [Abstract]
+//   Append the names which start with the given prefix to the result. The names should be sorted.
+//
+// [Args]
+//   result      (Vector<String>&)        : [OUT] Result list.
+//   scan        (const Scan&)            : [IN ] Result of the scan.
+//   offsets     (const Vector<uint32_t>&): [IN ] Offsets of the sorted names.
+//   prefix      (const String&)          : [IN ] Prefix of the names to be listed.
+//   n_max_items (uint32_t)               : [IN ] The maximum number of items in the result.
+//   show_dot    (bool)                   : [IN ] List dot files if true.
+//
+{   // {{{
+
+    const auto compare = [&scan](uint32_t offset, const String& key) noexcept -> bool
+    { return get_name(scan, offset) < key; };
+
+    // The names which start with the prefix are contiguous in the sorted list.
+    for (auto iter = std::lower_bound(offsets.begin(), offsets.end(), prefix, compare); iter != offsets.end(); ++iter)
+    {
+        const std::string_view name = get_name(scan, *iter);
+
+        if ((result.size() >= n_max_items) or (not name.starts_with(prefix)))
+            break;
+
+        if (show_dot or (name[0] != '.'))
+            result.emplace_back(name);
+    }
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Published functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Vector<String> list_directory(const Path& dir, const String& prefix, uint32_t n_max_items, bool show_dot) noexcept
+{   // {{{
+
+    Vector<String> result;
+
+    // Normalize the path to the absolute path so that the same directory shares the same cache
+    // entry, and the relative paths are not confused after changing the working directory.
+    std::error_code ec;
+    String key = std::filesystem::absolute(dir.empty() ? Path(".") : dir, ec).lexically_normal().string();
+    if ((key.size() > 1) and (key.back() == '/'))
+        key.pop_back();
+    if (key.size() == 0)
+        return result;
+
+    const std::shared_ptr<Listing> listing = get_listing(key);
+    if (not listing)
+        return result;
+
+    // Dot files are always shown if the prefix is a dot file.
+    show_dot = show_dot or prefix.starts_with('.');
+
+    // Huge directory: scan with the prefix filter and sort only the listed entries.
+    if (listing->huge)
+    {
+        Scan scan;
+        scan_directory(key, prefix, show_dot, SIZE_MAX, &scan);
+
+        sort_entries(scan, scan.dirs,  n_max_items);
+        sort_entries(scan, scan.files, n_max_items);
+
+        for (const Vector<uint32_t>* offsets : {&scan.dirs, &scan.files})
+            for (size_t idx = 0; (idx < offsets->size()) and (result.size() < n_max_items); ++idx)
+                result.emplace_back(get_name(scan, (*offsets)[idx]));
+
+        return result;
+    }
+
+    // List directories first, like `ls --group-directories-first`.
+    scan_range(result, listing->scan, listing->scan.dirs,  prefix, n_max_items, show_dot);
+    scan_range(result, listing->scan, listing->scan.files, prefix, n_max_items, show_dot);
+
+    return result;
+
+}   // }}}
+
+void clear_dir_cache(void) noexcept
+{   // {{{
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+
+    cache.clear();
+
+}   // }}}
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
@@ -0,0 +1,46 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ header file: dir_cache.hxx                                                               ///
+///                                                                                              ///
+/// This file defines the functions to list directory entries through a per-directory cache.    ///
+/// The entries of a directory are read once and kept sorted, so that a prefix query becomes a   ///
+/// binary search and a range scan. The cache is invalidated by the modification time of the     ///
+/// directory, which is checked at most once per `config.stat_cache_ttl` seconds. Directories    ///
+/// are read by getdents64 with the entry types from `d_type`, and too huge directories are not  ///
+/// cached but scanned with the prefix filter, where only the listed entries are sorted.         ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef DIR_CACHE_HXX
+#define DIR_CACHE_HXX
+
+// Include the headers of STL.
+#include <cstdint>
+
+// Include the headers of custom modules.
+#include "dtypes.hxx"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Published functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Vector<String> list_directory(const Path& dir, const String& prefix, uint32_t n_max_items, bool show_dot) noexcept;
+// [Abstract]
+//   Returns names of the entries in the given directory which start with the given prefix.
+//   Names of directories have the trailing slash, and the result is sorted in the same order
+//   as `ls --group-directories-first`. This function is thread-safe.
+//
+// [Args]
+//   dir         (const Path&)  : [IN] Path to the target directory.
+//   prefix      (const String&): [IN] Prefix of the names to be listed.
+//   n_max_items (uint32_t)     : [IN] The maximum number of items to be listed.
+//   show_dot    (bool)         : [IN] List dot files even if the prefix does not start with a dot.
+//
+// [Returns]
+//   (Vector<String>): List of names of the entries.
+
+void clear_dir_cache(void) noexcept;
+// [Abstract]
+//   Clear all cached directory listings.
+
+#endif
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
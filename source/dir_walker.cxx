@@ -0,0 +1,339 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ source file: dir_walker.cxx                                                              ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Include the primary header.
+#include "dir_walker.hxx"
+
+// Include the headers of STL.
+#include <algorithm>
+#include <chrono>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <fstream>
+#include <sys/stat.h>
+
+// Include the headers of custom modules.
+#include "utils.hxx"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// DirWalker: Constructors and destructors
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DirWalker::DirWalker(const Path& root, uint16_t max_depth, size_t max_entries, uint8_t n_workers)
+    : root(root), max_depth(max_depth), max_entries(max_entries), n_pending(1), cancelled(false), n_running(std::max<uint8_t>(n_workers, 1))
+{   // {{{
+
+    // The rules of ".gitignore" in the ancestors of the root are applied if the root is in a
+    // git work tree. The rules of the root and its descendants are loaded by the workers.
+    std::error_code ec;
+    Path root_abs = std::filesystem::weakly_canonical(std::filesystem::absolute(root, ec), ec);
+    if (root_abs.filename().empty())
+        root_abs = root_abs.parent_path();
+
+    Vector<Path> ancestors;
+    if ((not ec) and (not std::filesystem::exists(root_abs / ".git", ec)))
+    {
+        for (Path dir = root_abs.parent_path(); true; dir = dir.parent_path())
+        {
+            ancestors.push_back(dir);
+
+            // Found the top of the work tree.
+            if (std::filesystem::exists(dir / ".git", ec))
+                break;
+
+            // Not in a git work tree.
+            if (dir == dir.parent_path())
+            {
+                ancestors.clear();
+                break;
+            }
+        }
+    }
+
+    std::shared_ptr<const Ignore> ignore = nullptr;
+    for (auto iter = ancestors.rbegin(); iter != ancestors.rend(); ++iter)
+        ignore = DirWalker::load_ignore(ignore, *iter, "", root_abs.lexically_relative(*iter).string() + "/");
+
+    // Queue the root, and start the worker threads. The number of the workers is not read from
+    // `n_running` because the started workers may finish and decrement it.
+    const uint8_t n_threads = this->n_running;
+
+    for (uint8_t idx = 0; idx < n_threads; ++idx)
+        this->queues.push_back(std::make_unique<Queue>());
+
+    this->queues[0]->items.push_back({"", 0, ignore});
+
+    for (uint8_t idx = 0; idx < n_threads; ++idx)
+        this->workers.emplace_back(&DirWalker::run, this, idx);
+
+}   // }}}
+
+DirWalker::~DirWalker()
+{   // {{{
+
+    // The workers stop after reading the current directory.
+    this->cancelled = true;
+
+    for (std::thread& worker : this->workers)
+        worker.join();
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// DirWalker: Member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const Path& DirWalker::get_root(void) const noexcept
+{   // {{{
+
+    return this->root;
+
+}   // }}}
+
+bool DirWalker::fetch(Vector<String>& paths) noexcept
+{   // {{{
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    if (paths.size() < this->entries.size())
+        paths.insert(paths.end(), this->entries.begin() + paths.size(), this->entries.end());
+
+    return this->n_running == 0;
+
+}   // }}}
+
+bool DirWalker::is_updated(size_t n_fetched) noexcept
+{   // {{{
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    return (n_fetched < this->entries.size()) or (this->n_running == 0);
+
+}   // }}}
+
+bool DirWalker::wait(float timeout) noexcept
+{   // {{{
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    return this->cond.wait_for(lock, std::chrono::duration<float>(timeout), [this]() noexcept { return this->n_running == 0; });
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// DirWalker: Private member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void DirWalker::run(size_t id) noexcept
+{   // {{{
+
+    // Read directories until all queued directories are read. A directory is counted as pending
+    // until its subdirectories are queued, so the count becomes zero only at the end of the walk.
+    while ((not this->cancelled) and (this->n_pending > 0))
+    {
+        Item item;
+        if (this->pop(id, item))
+        {
+            this->read(id, item);
+            --this->n_pending;
+        }
+
+        // The other workers are reading the remaining directories.
+        else std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        --this->n_running;
+    }
+    this->cond.notify_all();
+
+}   // }}}
+
+bool DirWalker::pop(size_t id, Item& item) noexcept
+{   // {{{
+
+    // Take the deepest directory from the own queue to keep the working set small.
+    {
+        Queue& queue = *this->queues[id];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (queue.items.size() > 0)
+        {
+            item = std::move(queue.items.back());
+            queue.items.pop_back();
+            return true;
+        }
+    }
+
+    // Steal the shallowest directory, which is likely to have the largest subtree.
+    for (size_t offset = 1; offset < this->queues.size(); ++offset)
+    {
+        Queue& queue = *this->queues[(id + offset) % this->queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (queue.items.size() > 0)
+        {
+            item = std::move(queue.items.front());
+            queue.items.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+
+}   // }}}
+
+void DirWalker::read(size_t id, const Item& item) noexcept
+{   // {{{
+
+    const Path dir = item.rel.empty() ? this->root : this->root / item.rel;
+
+    DIR* dp = opendir(dir.c_str());
+    if (dp == nullptr)
+        return;
+
+    const std::shared_ptr<const Ignore> ignore = DirWalker::load_ignore(item.ignore, dir, item.rel, "");
+
+    Vector<String> found;
+    Vector<Item>   subdirs;
+
+    while (const struct dirent* ent = readdir(dp))
+    {
+        const String name = ent->d_name;
+        if ((name == ".") or (name == ".."))
+            continue;
+
+        unsigned char type = ent->d_type;
+
+        // Get the file type if the file system does not provide it. Symbolic links are not
+        // followed to avoid cycles.
+        if (type == DT_UNKNOWN)
+        {
+            struct stat st;
+            if (fstatat(dirfd(dp), ent->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+            else if (S_ISDIR(st.st_mode))                                       type = DT_DIR;
+        }
+
+        const bool is_dir = (type == DT_DIR);
+
+        // Skip hidden directories (e.g. ".git") and ignored entries.
+        if (is_dir and (name[0] == '.'))
+            continue;
+
+        const String rel = item.rel + name + (is_dir ? "/" : "");
+        if ((ignore != nullptr) and DirWalker::is_ignored(ignore.get(), rel, is_dir))
+            continue;
+
+        found.push_back(rel);
+
+        if (is_dir and (item.depth < this->max_depth))
+            subdirs.push_back({rel, static_cast<uint16_t>(item.depth + 1), ignore});
+    }
+
+    closedir(dp);
+
+    // Queue the subdirectories to the own queue, where the other workers may steal them.
+    if (subdirs.size() > 0)
+    {
+        Queue& queue = *this->queues[id];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        this->n_pending += subdirs.size();
+        std::move(subdirs.begin(), subdirs.end(), std::back_inserter(queue.items));
+    }
+
+    // Publish the entries.
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->entries.insert(this->entries.end(), std::make_move_iterator(found.begin()), std::make_move_iterator(found.end()));
+
+    if (this->entries.size() >= this->max_entries)
+        this->cancelled = true;
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// DirWalker: Private static functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<const DirWalker::Ignore> DirWalker::load_ignore(const std::shared_ptr<const Ignore>& parent, const Path& dir, const String& base, const String& prefix) noexcept
+{   // {{{
+
+    std::ifstream ifs(dir / ".gitignore");
+    if (not ifs)
+        return parent;
+
+    std::shared_ptr<Ignore> ignore = std::make_shared<Ignore>();
+    ignore->parent = parent;
+    ignore->base   = base;
+    ignore->prefix = prefix;
+
+    String line;
+    while (std::getline(ifs, line))
+    {
+        // Skip empty lines and comments.
+        line = strip(line);
+        if ((line.size() == 0) or (line[0] == '#'))
+            continue;
+
+        Rule rule = {line, false, false, false};
+
+        if (rule.pattern[0] == '!')
+        {
+            rule.negate  = true;
+            rule.pattern = rule.pattern.substr(1);
+        }
+
+        if (rule.pattern.ends_with('/'))
+        {
+            rule.dir_only = true;
+            rule.pattern.pop_back();
+        }
+
+        // A pattern which contains a slash is matched with the path from the directory.
+        rule.anchored = (rule.pattern.find('/') != String::npos);
+
+        if (rule.pattern.starts_with('/'))
+            rule.pattern = rule.pattern.substr(1);
+
+        if (rule.pattern.size() > 0)
+            ignore->rules.push_back(std::move(rule));
+    }
+
+    return ignore;
+
+}   // }}}
+
+bool DirWalker::is_ignored(const Ignore* ignore, const String& rel, bool is_dir) noexcept
+{   // {{{
+
+    // The rules of a deeper directory are checked first, and the last matched rule wins.
+    for (; ignore != nullptr; ignore = ignore->parent.get())
+    {
+        // Path of the entry from the directory of the rules (without the trailing slash).
+        String path = ignore->prefix + rel.substr(ignore->base.size());
+        if (is_dir)
+            path.pop_back();
+
+        const String name = path.substr(path.rfind('/') + 1);
+
+        for (auto iter = ignore->rules.rbegin(); iter != ignore->rules.rend(); ++iter)
+        {
+            if (iter->dir_only and (not is_dir))
+                continue;
+
+            const bool matched = iter->anchored ? (fnmatch(iter->pattern.c_str(), path.c_str(), FNM_PATHNAME) == 0)
+                                                : (fnmatch(iter->pattern.c_str(), name.c_str(), 0) == 0);
+            if (matched)
+                return not iter->negate;
+        }
+    }
+
+    return false;
+
+}   // }}}
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
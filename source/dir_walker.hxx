@@ -0,0 +1,200 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ header file: dir_walker.hxx                                                              ///
+///                                                                                              ///
+/// This file defines the class `DirWalker` which lists the entries under a directory            ///
+/// recursively on worker threads for the recursive path completion (e.g. "src/**/main"). Each   ///
+/// worker has its own queue of directories, and an idle worker steals the shallowest directory  ///
+/// from the others, so that a deep subtree is shared by all workers. Hidden directories and the ///
+/// entries ignored by ".gitignore" are skipped. The found entries are published as soon as each ///
+/// directory is read, and the walk can be cancelled at any time (e.g. when the completion       ///
+/// target is changed).                                                                          ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef DIR_WALKER_HXX
+#define DIR_WALKER_HXX
+
+// Include the headers of STL.
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Include the headers of custom modules.
+#include "dtypes.hxx"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Class definitions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class DirWalker
+{
+    public:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Constructors and destructors
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+         DirWalker(const Path& root, uint16_t max_depth, size_t max_entries, uint8_t n_workers);
+        ~DirWalker();
+        // [Abstract]
+        //   Constructor and destructor of DirWalker. The constructor starts the walk immediately,
+        //   and the destructor cancels the walk and stops the worker threads.
+        //
+        // [Args]
+        //   root        (const Path&): [IN] Root directory of the walk.
+        //   max_depth   (uint16_t)   : [IN] Maximum depth of the directories to be read (the root is 0).
+        //   max_entries (size_t)     : [IN] The walk stops when this number of entries are found.
+        //   n_workers   (uint8_t)    : [IN] Number of worker threads (at least one).
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        const Path& get_root(void) const noexcept;
+        // [Abstract]
+        //   Returns the root directory of the walk.
+
+        bool fetch(Vector<String>& paths) noexcept;
+        // [Abstract]
+        //   Append the entries found after the previous call to the given array, which should be
+        //   the same array given to the previous calls (i.e. its size is the number of the entries
+        //   already fetched). The entries are the relative paths from the root, and directories
+        //   have the trailing slash. The order of the entries is not defined.
+        //
+        // [Args]
+        //   paths (Vector<String>&): [IN/OUT] Entries fetched so far.
+        //
+        // [Returns]
+        //   (bool): True if the walk finished and all entries are fetched.
+
+        bool is_updated(size_t n_fetched) noexcept;
+        // [Abstract]
+        //   Returns true if new entries are found or the walk finished after the given number of
+        //   entries are fetched.
+        //
+        // [Args]
+        //   n_fetched (size_t): [IN] Number of the entries already fetched.
+
+        bool wait(float timeout) noexcept;
+        // [Abstract]
+        //   Wait until the walk finishes.
+        //
+        // [Args]
+        //   timeout (float): [IN] Maximum time to wait in seconds.
+        //
+        // [Returns]
+        //   (bool): True if the walk finished.
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private data types
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        typedef struct Rule
+        {
+            String pattern;   // Glob pattern of the rule without the leading and trailing slashes.
+            bool   negate;    // True if the rule starts with '!' (re-includes the matched entries).
+            bool   dir_only;  // True if the rule ends with '/' (matches only directories).
+            bool   anchored;  // True if the rule contains '/' (matches the path from the base).
+        }
+        Rule;
+        // A rule of ".gitignore".
+
+        typedef struct Ignore
+        {
+            std::shared_ptr<const Ignore> parent;  // Rules of the parent directories.
+            String                        base;    // Relative path of the directory from the root.
+            String                        prefix;  // Path of the root from the directory (only for the ancestors of the root).
+            Vector<Rule>                  rules;   // Rules of the ".gitignore" in the directory.
+        }
+        Ignore;
+        // Rules of ".gitignore" which are applied to a directory and its descendants.
+
+        typedef struct Item
+        {
+            String                        rel;     // Relative path of the directory from the root.
+            uint16_t                      depth;   // Depth of the directory.
+            std::shared_ptr<const Ignore> ignore;  // Rules applied to the directory.
+        }
+        Item;
+        // A directory to be read.
+
+        typedef struct Queue
+        {
+            Deque<Item> items;  // Directories to be read, where the deeper ones are at the back.
+            std::mutex  mutex;  // Mutex for the items.
+        }
+        Queue;
+        // Queue of directories owned by a worker thread.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member variables
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        Path root;
+        // Root directory of the walk.
+
+        uint16_t max_depth;
+        // Maximum depth of the directories to be read.
+
+        size_t max_entries;
+        // Maximum number of the entries to be found.
+
+        Vector<std::unique_ptr<Queue>> queues;
+        // Queues of the worker threads.
+
+        std::atomic<size_t> n_pending;
+        // Number of the directories which are queued or being read.
+
+        std::atomic<bool> cancelled;
+        // True if the walk should stop.
+
+        Vector<String> entries;
+        // Found entries.
+
+        uint8_t n_running;
+        // Number of the running worker threads.
+
+        std::mutex mutex;
+        // Mutex for the entries and the number of the running worker threads.
+
+        std::condition_variable cond;
+        // Condition variable to notify the end of the walk.
+
+        Vector<std::thread> workers;
+        // Worker threads.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        void run(size_t id) noexcept;
+        // [Abstract]
+        //   Main loop of the worker threads.
+
+        bool pop(size_t id, Item& item) noexcept;
+        // [Abstract]
+        //   Take the deepest directory from the own queue, or steal the shallowest directory from
+        //   the queue of another worker if the own queue is empty.
+
+        void read(size_t id, const Item& item) noexcept;
+        // [Abstract]
+        //   Read the directory, publish its entries, and queue its subdirectories.
+
+        static std::shared_ptr<const Ignore> load_ignore(const std::shared_ptr<const Ignore>& parent, const Path& dir, const String& base, const String& prefix) noexcept;
+        // [Abstract]
+        //   Returns the rules of the ".gitignore" in the directory appended to the parent rules,
+        //   or the parent rules if the directory does not have ".gitignore".
+
+        static bool is_ignored(const Ignore* ignore, const String& rel, bool is_dir) noexcept;
+        // [Abstract]
+        //   Returns true if the entry is ignored by the rules, where the last matched rule wins
+        //   and the rules of a deeper directory take precedence.
+};
+
+#endif
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
@@ -6,10 +6,22 @@
 #include "edit_helper.hxx"
 
 // Include the headers of STL.
-#include <regex>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <sys/stat.h>
 
 // Include the headers of custom modules.
+#include "cmd_index.hxx"
+#include "cmd_pool.hxx"
+#include "co_proc.hxx"
+#include "comp_rules.hxx"
 #include "config.hxx"
+#include "file_stat.hxx"
+#include "git_index.hxx"
+#include "hist_search.hxx"
+#include "opt_cache.hxx"
 #include "path_x.hxx"
 #include "preview.hxx"
 #include "string_x.hxx"
@@ -17,101 +29,372 @@
 
 #include <iostream>
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Static variables
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static std::future<void> future_commands;
+// Command names which are being scanned on a worker thread (see `EditHelper::prefetch_commands`).
+
+typedef struct ShellOutput
+{
+    String                                output;  // Output of the shell command.
+    std::chrono::steady_clock::time_point expire;  // Expiration time of the output.
+    String                                stamp;   // Stamp of the watched files (see `get_watch_stamp`).
+}
+ShellOutput;
+// Cached output of the shell command of SHELL completion.
+
+static Map<String, ShellOutput> shell_outputs;
+// Cache of the outputs of SHELL completion, where the key is the command and working directory.
+
+typedef struct OptWarmer
+{
+    OptCache          cache;   // Option cache shared by the completion and the warmer.
+    std::atomic<bool> stop;    // True if the warmer should stop (i.e. at exit).
+    std::future<void> future;  // Options which are being parsed on a worker thread.
+
+    OptWarmer(const Path& path) : cache(path), stop(false) {}
+    ~OptWarmer() { this->stop = true; if (this->future.valid()) this->future.wait(); }
+}
+OptWarmer;
+// Option cache and its background warmer (see `EditHelper::prefetch_options`). The warmer is
+// stopped and joined before the cache is destroyed.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Static functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static CmdPool& get_providers(void) noexcept
+// [Abstract]
+//   Returns the worker pool which runs the shell commands of completion providers.
+//   The pool is created at the first call (i.e. after the config is initialized).
+//
+{   // {{{
+
+    static CmdPool providers(config.provider_workers);
+
+    return providers;
+
+}   // }}}
+
+static CmdIndex& get_cmd_index(void) noexcept
+// [Abstract]
+//   Returns the index of the command names in PATH which is shared during the session.
+//
+{   // {{{
+
+    static CmdIndex cmd_index;
+
+    return cmd_index;
+
+}   // }}}
+
+static String get_env_path(void) noexcept
+// [Abstract]
+//   Returns the current value of PATH (empty string if not set).
+//
+{   // {{{
+
+    const char* env_path = std::getenv("PATH");
+
+    return (env_path != nullptr) ? String(env_path) : String("");
+
+}   // }}}
+
+static GitIndex& get_git_index(void) noexcept
+// [Abstract]
+//   Returns the index of the tracked files of git work trees which is shared during the session.
+//
+{   // {{{
+
+    static GitIndex git_index;
+
+    return git_index;
+
+}   // }}}
+
+static Vector<String> list_entries(const PathX& dir, uint32_t n_max_items, const String& prefix, bool show_dot) noexcept
+// [Abstract]
+//   Returns names of the entries in the directory which start with the given prefix, where the
+//   tracked files are listed from the git index if `config.git_completion` is true.
+//
+// [Args]
+//   dir         (const PathX&) : [IN] Target directory.
+//   n_max_items (uint32_t)     : [IN] The maximum number of items to be listed.
+//   prefix      (const String&): [IN] Prefix of the names to be listed.
+//   show_dot    (bool)         : [IN] List dot files even if the prefix does not start with a dot.
+//
+// [Returns]
+//   (Vector<String>): List of names of the entries (directories first).
+//
+{   // {{{
+
+    Vector<String> names;
+    if ((not config.git_completion) or (not get_git_index().list(dir, prefix, n_max_items, show_dot, names)))
+        return dir.listdir(n_max_items, prefix, show_dot);
+
+    if (not config.git_completion_untracked)
+        return names;
+
+    // Merge the entries in the file system, where directories come first.
+    const Vector<String> untracked = dir.listdir(n_max_items, prefix, show_dot);
+    names.insert(names.end(), untracked.begin(), untracked.end());
+
+    std::sort(names.begin(), names.end(), [](const String& a, const String& b) noexcept
+    { return (a.ends_with('/') != b.ends_with('/')) ? a.ends_with('/') : (a < b); });
+
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    names.resize(std::min<size_t>(names.size(), n_max_items));
+
+    return names;
+
+}   // }}}
+
+static OptWarmer& get_opt_warmer(void) noexcept
+// [Abstract]
+//   Returns the option cache and its background warmer.
+//   The cache is created at the first call (i.e. after the config is initialized).
+//
+{   // {{{
+
+    static OptWarmer opt_warmer(Path(replace(config.path_optcache, "~", getenv("HOME"))));
+
+    return opt_warmer;
+
+}   // }}}
+
+static OptCache& get_opt_cache(void) noexcept
+// [Abstract]
+//   Returns the option cache which is shared by the completion and the background warmer.
+//
+{   // {{{
+
+    return get_opt_warmer().cache;
+
+}   // }}}
+
+static String colorize_path(const PathX& dir, const String& name) noexcept
+// [Abstract]
+//   Colorize the name of the path candidate.
+//
+// [Args]
+//   dir  (const PathX&) : [IN] Directory of the candidate.
+//   name (const String&): [IN] Name of the candidate (directories have the trailing slash).
+//
+// [Returns]
+//   (String): Colorized name.
+//
+{   // {{{
+
+    // Case 1: directory.
+    if (name.size() > 0 and name.back() == '/')
+        return "\x1B[94m" + name + "\x1B[m";
+
+    // Case 2: executable.
+    if (get_file_stat(dir / name).is_exec)
+        return "\x1B[92m" + name + "\x1B[m";
+
+    return name;
+
+}   // }}}
+
+static size_t get_common_size(std::string_view a, std::string_view b) noexcept
+// [Abstract]
+//   Returns the byte size of the common prefix of the given strings, where a multi-byte
+//   character is never split.
+//
+// [Args]
+//   a (std::string_view): [IN] First string.
+//   b (std::string_view): [IN] Second string.
+//
+// [Returns]
+//   (size_t): Byte size of the common prefix.
+//
+{   // {{{
+
+    size_t n_common = std::mismatch(a.begin(), a.end(), b.begin(), b.end()).first - a.begin();
+
+    while ((n_common > 0) and (n_common < a.size()) and ((a[n_common] & 0xC0) == 0x80))
+        --n_common;
+
+    return n_common;
+
+}   // }}}
+
+static size_t select_best(Vector<Pair<int32_t, uint32_t>>& scored, size_t k) noexcept
+// [Abstract]
+//   Move the best `k` items of the fuzzy matching to the front in descending order of the score,
+//   where the items of the same score are sorted by the index.
+//
+// [Args]
+//   scored (Vector<Pair<int32_t, uint32_t>>&): [IN/OUT] Pairs of the score and index.
+//   k      (size_t)                           : [IN    ] Number of items to be selected.
+//
+// [Returns]
+//   (size_t): Number of the selected items.
+//
+{   // {{{
+
+    constexpr auto greater = [](const Pair<int32_t, uint32_t>& a, const Pair<int32_t, uint32_t>& b) noexcept -> bool
+    { return (a.first > b.first) or ((a.first == b.first) and (a.second < b.second)); };
+
+    k = std::min(k, scored.size());
+    std::partial_sort(scored.begin(), scored.begin() + k, scored.end(), greater);
+
+    return k;
+
+}   // }}}
+
+static String get_watch_stamp(const Vector<String>& watch, const Path& cwd) noexcept
+// [Abstract]
+//   Returns a string which changes if one of the watched files is modified (or created/removed).
+//   Relative paths are searched from the working directory to the root directory like git,
+//   therefore ".git/HEAD" works in any subdirectory of a repository.
+//
+// [Args]
+//   watch (const Vector<String>&): [IN] Paths to the watched files.
+//   cwd   (const Path&)          : [IN] Working directory.
+//
+// [Returns]
+//   (String): Stamp of the watched files.
+//
+{   // {{{
+
+    String stamp;
+
+    for (const String& pattern : watch)
+    {
+        const Path path = pattern.starts_with("~/") ? Path(getenv("HOME")) / pattern.substr(2) : Path(pattern);
+
+        // Find the nearest existing file.
+        struct stat st;
+        bool found = false;
+        for (Path dir = cwd; not found; dir = dir.parent_path())
+        {
+            found = (::stat((path.is_absolute() ? path : dir / path).c_str(), &st) == 0);
+
+            if (path.is_absolute() or (dir == dir.parent_path()))
+                break;
+        }
+
+        // Use the inode, size, and modification time as the stamp.
+        if (found) stamp += std::to_string(st.st_ino) + ":" + std::to_string(st.st_size) + ":" + std::to_string(st.st_mtim.tv_sec) + "." + std::to_string(st.st_mtim.tv_nsec) + ";";
+        else       stamp += "-;";
+    }
+
+    return stamp;
+
+}   // }}}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // EditHelper: Constructors and destructors
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-EditHelper::EditHelper(const TermSize area)
+EditHelper::EditHelper(const TermSize area) : n_total(0), has_context(false), pages({0}), page_size(0), request_id(0), requested(false), wait_provider(true), walk_done(false), walk_used(false)
 {   // {{{
 
     // Get terminal size.
     this->area = area;
 
-    // Create the cache of available command names.
-    this->cache_commands = get_system_commands();
+    // Get available command names. Only the directories in PATH modified since the last prompt
+    // (or added to PATH by `set -x`) are read again.
+    this->cache_commands = get_cmd_index().get(get_env_path());
+
+}   // }}}
+
+EditHelper::~EditHelper(void)
+{   // {{{
+
+    // The output of the pending provider is no longer needed.
+    this->cancel_request();
 
 }   // }}}
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
-// EditHelper: Member functions
+// EditHelper: Static functions
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Vector<StringX> EditHelper::candidate(const StringX& lhs) noexcept
+void EditHelper::prefetch_commands(void) noexcept
 {   // {{{
 
-    constexpr auto match = [](const Vector<String>& patterns, const Vector<String>& tokens) noexcept -> bool
-    // [Abstract]
-    //   Return True if the given tokens matched with the given patterns.
-    //   The arguments `tokens` is a list of strings, and the argument `patterns`
-    //   are list of regular expression strings with the following extra special commands:
-    //
-    //     * "FILE": existing file path
-    //     * ">>"  : skip tokens (available only 1 time in one patterns)
-    //
-    // [Args]
-    //   patterns (const Vector<String>&): [IN] List of regular expression strings.
-    //   tokens   (const Vector<String>&): [IN] List of strings to be matched.
-    //
-    // [Returns]
-    //   (bool): True is the given tokens matched with the given patterns.
+    // Scan PATH on a worker thread. The result will be used by the next EditHelper instance.
+    future_commands = std::async(std::launch::async, [env_path = get_env_path()]() noexcept
     {
-        // Initialize token index.
-        size_t index_token = 0;
+        get_cmd_index().get(env_path);
+    });
 
-        // Run the for-loop based on the pattern index.
-        for (size_t index_pattern = 0; index_pattern < patterns.size(); ++index_pattern)
-        {
-            // If the number of patterns is longer than the number of tokens
-            // (i.e. token finished but pattern is exists yet), then returns false.
-            if (index_token >= tokens.size())
-                return false;
+}   // }}}
 
-            // Select target pattern and token.
-            const String pattern = patterns[index_pattern];
-            const String token   = tokens[index_token];
+void EditHelper::prefetch_options(const Deque<StringX>& hists) noexcept
+{   // {{{
 
-            // Case 1: pattern is ">>".
-            if (pattern == ">>")
-                index_token = tokens.size() - patterns.size() + index_pattern;
+    OptWarmer& warmer = get_opt_warmer();
 
-            // Case 2: pattern is "FILE" but the file not exists.
-            else if (pattern == "FILE" and (not std::filesystem::exists(token)))
-                return false;
+    // Do nothing if still parsing.
+    if (warmer.future.valid() and (warmer.future.wait_for(std::chrono::seconds(0)) != std::future_status::ready))
+        return;
 
-            // Case 3: pattern is "FILE" and the file exists.
-            else if (pattern == "FILE") /* pass */;
+    // Count the commands which are used with options.
+    Map<String, uint32_t> counts;
+    for (const StringX& hist : hists)
+    {
+        Vector<String> tokens;
+        for (const StringX& token : hist.tokenize())
+            if ((token.size() > 0) and (token[0].value != ' '))
+                tokens.push_back(token.string());
+
+        const auto has_option = [](const String& token) noexcept -> bool { return token.starts_with('-'); };
+        if ((tokens.size() > 1) and std::any_of(tokens.begin() + 1, tokens.end(), has_option))
+            counts[tokens[0]] += 1;
+    }
 
-            // Case 4: others.
-            else if (not regex_match(token, std::regex(pattern)))
-                return false;
+    // Select the most frequent commands.
+    Vector<Pair<String, uint32_t>> ranking(counts.begin(), counts.end());
+    const size_t n_top = std::min<size_t>(ranking.size(), config.optcache_warm_commands);
+    std::partial_sort(ranking.begin(), ranking.begin() + n_top, ranking.end(),
+                      [](const auto& a, const auto& b) noexcept { return a.second > b.second; });
+    ranking.resize(n_top);
+
+    // Parse the options on a worker thread. The commands are run by its own pool so that the
+    // running command can be killed on timeout or at exit, and the pool is never destroyed while
+    // in use.
+    warmer.future = std::async(std::launch::async, [ranking, &warmer]() noexcept
+    {
+        CmdPool pool(1);
 
-            ++index_token;
-        };
+        for (const auto& [command, count] : ranking)
+        {
+            if (warmer.stop)
+                break;
+
+            OptCache::Table table;
+            if (warmer.cache.get(command, table) or (OptCache::resolve(command).size() == 0))
+                continue;
+
+            // Wait for the command in short steps to stop soon at exit.
+            String output;
+            bool   finished = false;
+            const uint64_t id = pool.submit(command + " --help");
+            for (float waited = 0.0f; (not finished) and (not warmer.stop) and (waited < config.provider_timeout); waited += 0.1f)
+                finished = pool.poll(id, 0.1f, output);
+
+            if (finished) warmer.cache.put(command, output);
+            else          pool.cancel(id);
+        }
+    });
 
-        // No unprocessed tokens remains if the token matches with the pattern.
-        return (index_token == tokens.size());
-    };
+}   // }}}
 
-    constexpr auto get_target = [match](const Vector<String>& tokens) noexcept -> auto
-    // [Abstract]
-    //   Returns a pair of target completion type and it's optional string.
-    //
-    // [Args]
-    //   tokens (const Vector<String>&): [IN] List of strings to be matched.
-    //
-    // [Returns]
-    //   comp_type (EditHelper::CompType): Target completion type.
-    //   option    (String)         : Optional string of the target completion.
-    {
-        for (const auto& [patterns, comp_type, option] : config.completions)
-            if (match(patterns, tokens))
-                return std::make_tuple(comp_type, option);
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// EditHelper: Member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-        return std::make_tuple(EditHelper::CompType::NONE, String(""));
-    };
+Vector<StringX> EditHelper::candidate(const StringX& lhs, bool wait) noexcept
+{   // {{{
 
-    // Clear completion candidates.
-    this->cands.clear();
+    // Completion rules which are compiled at the first call.
+    static const CompRules rules = CompRules(config.completions);
 
     // Split the given text (left hand side of the cursor) to tokens.
     Vector<StringX> tokens = lhs.tokenize();
@@ -127,20 +410,87 @@ Vector<StringX> EditHelper::candidate(const StringX& lhs) noexcept
         tokens_str.push_back("");
 
     // Get completion type and it's optional string.
-    const auto& [comp_type, option] = get_target(tokens_str);
-
-    // Compute lines of completion candidates that will be displayed to users.
-    switch (comp_type)
-    {
-        case EditHelper::CompType::COMMAND: this->cands_command (tokens, option); break;
-        case EditHelper::CompType::OPTION : this->cands_option  (tokens);         break;
-        case EditHelper::CompType::PATH   : this->cands_filepath(tokens);         break;
-        case EditHelper::CompType::PREVIEW: this->cands_filepath(tokens);         break;
-        case EditHelper::CompType::SHELL  : this->cands_shell   (tokens, option); break;
-        case EditHelper::CompType::SUBCMD : this->cands_subcmd  (tokens, option); break;
-        case EditHelper::CompType::NONE   : this->cands_filepath(tokens);         break;
+    static const CompRules::Rule rule_none = {{}, EditHelper::CompType::NONE, ""};
+    const CompRules::Rule* rule      = rules.find_rule(tokens_str);
+    const CompType         comp_type = (rule != nullptr) ? rule->type   : rule_none.type;
+    const String&          option    = (rule != nullptr) ? rule->option : rule_none.option;
+
+    // Keep the current candidates and page if the input is not changed (e.g. redrawn by the
+    // real-time completion). Otherwise, the first page of the new candidates is shown.
+    const auto& [lhs_prev, comp_type_prev, option_prev] = this->context;
+    const bool unchanged = this->has_context and (this->request_id == 0) and ((this->walker == nullptr) or this->walk_done)
+                       and (lhs == lhs_prev) and (comp_type == comp_type_prev) and (option == option_prev);
+
+    if (not unchanged)
+        this->pages = {0};
+
+    // Narrow the current candidates if the user just typed more characters of the last token.
+    // Otherwise, compute the candidates from scratch.
+    if ((not unchanged) and (not this->narrow_cands(lhs, comp_type, option)))
+    {
+        // Keep the current candidates to show them while the provider is running.
+        Vector<Pair<String, String>> cands_prev = std::move(this->cands);
+        Vector<String>               keys_prev  = std::move(this->keys);
+        String                       query_prev = std::move(this->query);
+        Pair<size_t, String>         total_prev = {this->n_total, std::move(this->common)};
+        Path                         dir_prev   = std::move(this->cands_dir);
+
+        // Clear completion candidates.
+        this->cands.clear();
+        this->keys.clear();
+        this->query.clear();
+        this->n_total = 0;
+        this->common.clear();
+        this->cands_dir.clear();
+
+        this->requested     = false;
+        this->wait_provider = wait;
+        this->walk_used     = false;
+
+        // Compute lines of completion candidates that will be displayed to users.
+        switch (comp_type)
+        {
+            case EditHelper::CompType::COMMAND: this->cands_command (tokens, option); break;
+            case EditHelper::CompType::OPTION : this->cands_option  (tokens);         break;
+            case EditHelper::CompType::PATH   : this->cands_filepath(tokens);         break;
+            case EditHelper::CompType::PLUGIN : this->cands_plugin  (tokens, option); break;
+            case EditHelper::CompType::PREVIEW: this->cands_filepath(tokens);         break;
+            case EditHelper::CompType::SHELL  : this->cands_shell   (tokens, option, rule->ttl, rule->watch); break;
+            case EditHelper::CompType::SUBCMD : this->cands_subcmd  (tokens, option); break;
+            case EditHelper::CompType::NONE   : this->cands_filepath(tokens);         break;
+        }
+
+        // Cancel the provider request and the walk which are no longer needed.
+        if (not this->requested)
+            this->cancel_request();
+
+        if (not this->walk_used)
+        {
+            this->walker.reset();
+            this->walked.clear();
+        }
+
+        // Show the previous candidates until the provider finishes. The context is not updated,
+        // so that the candidates will be recomputed at the next call.
+        if (this->request_id != 0)
+        {
+            this->cands = std::move(cands_prev);
+            this->keys  = std::move(keys_prev);
+            this->query = std::move(query_prev);
+            std::tie(this->n_total, this->common) = std::move(total_prev);
+            this->cands_dir = std::move(dir_prev);
+        }
+        else
+        {
+            this->context     = {lhs, comp_type, option};
+            this->has_context = true;
+        }
     }
 
+    // Order the candidates by the score of the fuzzy matching.
+    if (config.fuzzy_completion and (not unchanged))
+        this->rank_cands();
+
     // Returns candidates.
     this->lines_from_cands(this->cands);
 
@@ -152,58 +502,45 @@ Vector<StringX> EditHelper::candidate(const StringX& lhs) noexcept
 
 }   // }}}
 
-StringX EditHelper::complete(const StringX& lhs) const noexcept
+bool EditHelper::is_ready(void) noexcept
 {   // {{{
 
-    constexpr auto get_common_substr = [](const Vector<StringX>& texts) noexcept -> StringX
-    // [Abstract]
-    //   Get common substring of the given strings.
-    //
-    // [Args]
-    //   texts (const Vector<StringX>&): [IN] List of strings.
-    //
-    // [Returns]
-    //   (StringX): Common string in the given list of strings.
-    {
-        // Initialize output string.
-        StringX result;
+    // The entries found by the directory walker are also shown while walking.
+    if ((this->walker != nullptr) and (not this->walk_done) and this->walker->is_updated(this->walked.size()))
+        return true;
 
-        // Returns empty string if the size of the given text list is zero.
-        if (texts.size() == 0)
-            return result;
+    if (this->request_id == 0)
+        return false;
 
-        // Find minimul length of the given texts.
-        uint32_t min_size = texts[0].size();
-        for (uint32_t n = 1; n < texts.size(); ++n)
-            min_size = std::min(min_size, static_cast<uint32_t>(texts[n].size()));
+    if (this->request_plugin.size() > 0)
+        return get_coproc(this->request_plugin, config.plugin_timeout).finished(this->request_id);
 
-        // Check consistency for each character and append to the result string.
-        for (uint32_t m = 0; m < min_size; ++m)
-        {
-            // Check the character consistency.
-            for (uint32_t n = 1; n < texts.size(); ++n)
-                if (texts[n][m].value != texts[0][m].value)
-                    return result;
+    return get_providers().finished(this->request_id);
 
-            // Append to the result string.
-            result += texts[0][m];
-        }
+}   // }}}
 
-        return result;
-    };
+Vector<StringX> EditHelper::scroll(int8_t n_pages) noexcept
+{   // {{{
 
-    constexpr auto get_first = [](const Pair<StringX, StringX>& pair) noexcept -> StringX
-    // [Abstract]
-    //   Get the first string of the given string pair.
-    //
-    // [Args]
-    //   pair (const Pair<StringX, StringX>&): [IN] Pair of strings.
-    //
-    // [Returns]
-    //   (StringX): First string of the pair.
+    // Go to the next pages while some candidates are left, or go back to the previous pages.
+    // The size of each page depends on the widths of the candidates in the page.
+    for (; (n_pages > 0) and (this->pages.back() + this->page_size < this->cands.size()); --n_pages)
     {
-        return pair.first;
-    };
+        this->pages.push_back(this->pages.back() + this->page_size);
+        this->lines_from_cands(this->cands);
+    }
+
+    for (; (n_pages < 0) and (this->pages.size() > 1); ++n_pages)
+        this->pages.pop_back();
+
+    this->lines_from_cands(this->cands);
+
+    return this->lines;
+
+}   // }}}
+
+StringX EditHelper::complete(const StringX& lhs) const noexcept
+{   // {{{
 
     // Split the given text (left hand side of the cursor) to tokens.
     Vector<StringX> tokens = lhs.tokenize();
@@ -222,33 +559,49 @@ StringX EditHelper::complete(const StringX& lhs) const noexcept
     for (size_t idx = 0; idx < (tokens.size() - 1); ++idx)
         lhs_without_last_token += tokens[idx];
 
+    // The common prefix of the fuzzy matching is used only if it extends the last token.
+    const auto extends = [&tokens](const String& common) noexcept -> bool
+    { return (common.size() > 0) and ((not config.fuzzy_completion) or common.starts_with(tokens.back().strip().string())); };
+
+    // The recursive candidates are completed only if unique, because their common prefix drops
+    // the "**" pattern which the user typed.
+    if ((this->walker != nullptr) and (num_cands > 1))
+        return lhs;
+
+    // Use the common prefix of all matched candidates if the candidates are capped.
+    if (this->n_total > num_cands)
+        return extends(this->common) ? lhs_without_last_token + StringX(this->common.c_str()) : lhs;
+
     // Compute completion string.
-    if (num_cands == 1 and this->cands[0].first.endswith('/'))
+    if (num_cands == 1 and this->cands[0].first.ends_with('/'))
     {
         // Extra slash will be added when directory path is completed.
         // However, slash is already added to the completion token,
         // therefore just adding the completion token is enough.
-        return lhs_without_last_token + this->cands[0].first;
+        return lhs_without_last_token + StringX(this->cands[0].first.c_str());
     }
 
     if (num_cands == 1)
     {
         // Add extra white-space at the end if number of completion candidate is one.
-        return lhs_without_last_token + this->cands[0].first + CharX(' ');
+        return lhs_without_last_token + StringX(this->cands[0].first.c_str()) + CharX(' ');
     }
 
-    // Create an array of completion strings.
-    Vector<StringX> keys = transform<Pair<StringX, StringX>, StringX>(this->cands, get_first);
-
     // Compute common substring of the completion strings.
-    StringX common_substr = get_common_substr(keys);
+    const std::string_view first = this->cands[0].first;
+
+    size_t n_common = first.size();
+    for (const auto& cand : this->cands)
+        n_common = get_common_size(first.substr(0, n_common), cand.first);
+
+    const String common_substr = String(first.substr(0, n_common));
 
     // Do nothing if the common substring is empty.
-    if (common_substr.size() == 0)
+    if (not extends(common_substr))
         return lhs;
 
     // Returns completed string.
-    return lhs_without_last_token + common_substr;
+    return lhs_without_last_token + StringX(common_substr.c_str());
 
 }   // }}}
 
@@ -264,38 +617,86 @@ void EditHelper::cands_command(const Vector<StringX>& tokens, const String& opti
 
     // Get query token.
     const StringX token = tokens[0];
+    this->query = token.string();
+
+    const CmdIndex::Names& names = *this->cache_commands;
+
+    // Keep only the candidates which can be browsed by the pager.
+    const uint32_t n_max_cands = config.completion_max_cands;
+
+    // Fuzzy matching: score the names which contain all characters of the query (checked by the
+    // character masks at first), and select the best ones.
+    if (config.fuzzy_completion)
+    {
+        const uint64_t mask = HistSearch::charmask(this->query);
+
+        Vector<Pair<int32_t, uint32_t>> scored;
+        for (uint32_t idx = 0; idx < names.masks.size(); ++idx)
+        {
+            if ((names.masks[idx] & mask) != mask)
+                continue;
 
-    // Filter matched command names.
-    for (const StringX& cmd : this->cache_commands)
-        if (cmd.startswith(token))
+            const int32_t score = HistSearch::score(CmdIndex::name(names, idx), this->query);
+            if (score >= 0)
+                scored.emplace_back(score, idx);
+        }
+
+        const size_t n_selected = select_best(scored, n_max_cands);
+        for (size_t n = 0; n < n_selected; ++n)
+        {
+            const String cmd = String(CmdIndex::name(names, scored[n].second));
             this->cands.emplace_back(cmd, cmd);
+            this->keys.push_back(cmd);
+        }
 
-}   // }}}
+        // Compute the common prefix of all matched names if they are capped.
+        this->n_total = scored.size();
 
-void EditHelper::cands_filepath(const Vector<StringX>& tokens) noexcept
-{   // {{{
+        if (this->n_total > n_selected)
+        {
+            const std::string_view first = CmdIndex::name(names, scored[0].second);
 
-    constexpr auto colorize_token = [](const PathX& dir, const String& token) noexcept -> String
-    // [Abstract]
-    //   Colorize the given token.
-    //
-    // [Args]
-    //   token (const String&): [IN] Target token to be colorized.
-    //
-    // [Returns]
-    //   (String): Colorized token.
+            size_t n_common = first.size();
+            for (const auto& [_, idx] : scored)
+                n_common = get_common_size(first.substr(0, n_common), CmdIndex::name(names, idx));
+
+            this->common = String(first.substr(0, n_common));
+        }
+
+        return;
+    }
+
+    // Find the range of matched command names by a binary search.
+    const auto [idx_bgn, idx_end] = CmdIndex::range(names, this->query);
+
+    for (uint32_t idx = idx_bgn; idx < std::min(idx_end, idx_bgn + n_max_cands); ++idx)
     {
-        // Case 1: directory.
-        if (token.size() > 0 and token.back() == '/')
-            return "\x1B[94m" + token + "\x1B[m";
+        const String cmd = String(CmdIndex::name(names, idx));
+        this->cands.emplace_back(cmd, cmd);
+        this->keys.push_back(cmd);
+    }
 
-        // Case 2: executable.
-        std::filesystem::perms perms = std::filesystem::status(dir / token).permissions();
-        if (static_cast<int>(perms) & static_cast<int>(std::filesystem::perms::owner_exec))
-            return "\x1B[92m" + token + "\x1B[m";
+    // The common prefix of all matched names is the one of the first and last names because
+    // the names are sorted.
+    this->n_total = idx_end - idx_bgn;
 
-        return token;
-    };
+    if (this->n_total > this->cands.size())
+    {
+        const std::string_view first = CmdIndex::name(names, idx_bgn);
+        const std::string_view last  = CmdIndex::name(names, idx_end - 1);
+
+        this->common = String(first.substr(0, get_common_size(first, last)));
+    }
+
+}   // }}}
+
+void EditHelper::cands_filepath(const Vector<StringX>& tokens) noexcept
+{   // {{{
+
+    // Complete the paths under the directory recursively if the token contains "**".
+    const String token = (tokens.size() > 0) ? tokens.back().strip().string() : String("");
+    if (const size_t pos = token.find("**"); pos != String::npos)
+        return this->cands_recursive(token, pos);
 
     // Split user input token to a tuple of:
     //   * directory path to be searched,
@@ -304,17 +705,125 @@ void EditHelper::cands_filepath(const Vector<StringX>& tokens) noexcept
 
     // Show dot file if current file name started with dot.
     const bool show_dot = (query_key.size() > 0) and (query_key[0] == '.');
+    this->query = query_key;
 
-    // Search the directory and filter out unnecessary search results.
-    for (const String& name : query_dir.listdir())
+    // Search the directory, where the entries are filtered by the query key in the listing.
+    // The fuzzy matching lists all entries and selects the best ones.
+    Vector<String> names;
+    if (config.fuzzy_completion)
     {
-        // Skip dot files if the query key is not a dot file.
-        if ((not show_dot) and (name[0] == '.'))
-            continue;
+        const Vector<String> entries = list_entries(query_dir, UINT32_MAX, "", show_dot);
 
+        Vector<Pair<int32_t, uint32_t>> scored;
+        for (uint32_t idx = 0; idx < entries.size(); ++idx)
+            if (const int32_t score = HistSearch::score(entries[idx], query_key); score >= 0)
+                scored.emplace_back(score, idx);
+
+        // The common prefix is not computed for the capped candidates, that is, the token is not
+        // completed until the candidates are narrowed enough.
+        const size_t n_selected = select_best(scored, config.completion_max_cands);
+        for (size_t n = 0; n < n_selected; ++n)
+            names.push_back(entries[scored[n].second]);
+
+        this->n_total = scored.size();
+    }
+    else names = list_entries(query_dir, config.completion_max_cands, query_key, show_dot);
+
+    // The display strings are colorized when they are shown (see `describe`), because it needs
+    // the metadata of each file.
+    this->cands_dir = query_dir;
+
+    for (const String& name : names)
+    {
         // Append to the candidates (a pair of query string and display string).
-        if (name.starts_with(query_key))
-            this->cands.emplace_back((query_dir / name).shorten().c_str(), colorize_token(query_dir, name).c_str());
+        this->cands.emplace_back((query_dir / name).shorten(), "");
+        this->keys.push_back(name);
+    }
+
+}   // }}}
+
+void EditHelper::cands_recursive(const String& token, size_t pos) noexcept
+{   // {{{
+
+    // Split the token to the root directory of the walk and the query, e.g. "src/**/main" is
+    // split to "src/" and "main".
+    const String root_str = token.substr(0, pos);
+    const PathX  root     = PathX((root_str.size() > 0) ? root_str.c_str() : "./");
+
+    String query = token.substr(pos + 2);
+    query.erase(0, query.find_first_not_of('/'));
+
+    // Restart the walk if the root is changed. The walk does not depend on the query, so the
+    // entries are reused while the user types the query.
+    if ((this->walker == nullptr) or (this->walker->get_root() != root))
+    {
+        this->walker = std::make_unique<DirWalker>(root, config.walker_max_depth, config.walker_max_entries, config.walker_workers);
+        this->walked.clear();
+    }
+
+    // The completion by TAB waits for the walk, and the real-time completion shows the entries
+    // found so far (the candidates are recomputed when new entries are found, see `is_ready`).
+    if (this->wait_provider)
+        this->walker->wait(config.provider_timeout);
+
+    this->walk_used = true;
+    this->walk_done = this->walker->fetch(this->walked);
+    this->query     = query;
+
+    // Show the hidden files only if the query starts with a dot.
+    const bool show_dot = (query.size() > 0) and (query[query.rfind('/') + 1] == '.');
+
+    const auto is_hidden = [](const String& rel) noexcept -> bool
+    {
+        const size_t pos_name = rel.rfind('/', rel.size() - 2);
+        return rel[(pos_name == String::npos) ? 0 : pos_name + 1] == '.';
+    };
+
+    // Returns true if a component of the path starts with the query.
+    const auto is_matched = [&query](const String& rel) noexcept -> bool
+    {
+        for (size_t pos_comp = 0; pos_comp < rel.size(); pos_comp = rel.find('/', pos_comp) + 1)
+        {
+            if (std::string_view(rel).substr(pos_comp).starts_with(query))
+                return true;
+
+            // No more components.
+            if (rel.find('/', pos_comp) == String::npos)
+                break;
+        }
+        return false;
+    };
+
+    Vector<Pair<int32_t, uint32_t>> scored;
+    for (uint32_t idx = 0; idx < this->walked.size(); ++idx)
+    {
+        const String& rel = this->walked[idx];
+
+        if ((not show_dot) and is_hidden(rel))
+            continue;
+
+        if (config.fuzzy_completion)
+        {
+            if (const int32_t score = HistSearch::score(rel, query); score >= 0)
+                scored.emplace_back(score, idx);
+        }
+        else if (is_matched(rel))
+            scored.emplace_back(0, idx);
+    }
+
+    // The entries are found in an arbitrary order, so the candidates of the same score are
+    // sorted by the path.
+    std::sort(scored.begin(), scored.end(), [this](const auto& a, const auto& b) noexcept
+    { return (a.first != b.first) ? (a.first > b.first) : (this->walked[a.second] < this->walked[b.second]); });
+
+    this->n_total   = scored.size();
+    this->cands_dir = root;
+
+    for (size_t n = 0; n < std::min<size_t>(scored.size(), config.completion_max_cands); ++n)
+    {
+        const String& rel = this->walked[scored[n].second];
+        this->cands.emplace_back(root_str + rel, "");
+        this->keys.push_back(rel);
     }
 
 }   // }}}
@@ -323,55 +832,99 @@ void EditHelper::cands_option(const Vector<StringX>& tokens) noexcept
 {   // {{{
 
     // Cache of the command options.
-    static Map<StringX, Map<StringX, StringX>> opt_cache;
+    static Map<StringX, OptCache::Table> opt_cache;
 
     // Get the target command.
     StringX command = (tokens.size() > 0) ? tokens[0].strip() : StringX("");
 
-    // Run command with "--help" option if not registered in the cache.
+    // Get the options if not registered in the cache.
     if (not opt_cache.contains(command))
     {
-        // Create new map instance.
-        opt_cache[command] = Map<StringX, StringX>();
-
-        // Run the given command with "--help" option.
-        const String output = run_command(command.string() + " --help");
-
-        // parse the output.
-        for (String line : split(output, "\n"))
+        // Use the options stored in the cache file if the binary of the command is not updated.
+        // Otherwise, run the given command with "--help" option, and do nothing until the command
+        // finishes on the worker thread.
+        OptCache::Table table;
+        if (not get_opt_cache().get(command.string(), table))
         {
-            // Strip whitespaces from the line.
-            line = strip(line);
-
-            for (String elem : split(line, " "))
-            {
-                // Strip whitespaces from the token.
-                elem = strip(elem);
-
-                // Remove after comma if exists.
-                String::size_type pos_comma = elem.find(',');
-                if (pos_comma != String::npos)
-                    elem.erase(pos_comma);
-
-                // Remove after equal sign if exists.
-                String::size_type pos_equal = elem.find('=');
-                if (pos_equal != String::npos)
-                    elem.erase(pos_equal);
-
-                // Both the token and line starts with '-', then register the option to the cache.
-                if ((elem.size() > 0 and elem[0] == '-') and (line.size() > 0 and line[0] == '-'))
-                    opt_cache[command][StringX(elem.c_str())] = StringX(line.c_str());
-            }
+            String output;
+            if (not this->request(command.string() + " --help", output))
+                return;
+
+            table = get_opt_cache().put(command.string(), output);
         }
+
+        opt_cache[command] = std::move(table);
     }
 
     // Get query token.
     const StringX token = (tokens.size() > 0) ? tokens.back().strip() : StringX("");
+    this->query = token.string();
 
     // Add matched options.
     for (const auto& [opt, desc] : opt_cache[command])
-        if (opt.startswith(token))
-            this->cands.emplace_back(opt, desc);
+    {
+        if (this->matches(opt.string()))
+        {
+            this->cands.emplace_back(opt.string(), desc.string());
+            this->keys.push_back(opt.string());
+        }
+    }
+
+}   // }}}
+
+void EditHelper::cands_plugin(const Vector<StringX>& tokens, const String& option) noexcept
+{   // {{{
+
+    // Get the target token.
+    const StringX token = (tokens.size() > 0) ? tokens.back().strip() : StringX("");
+    this->query = token.string();
+
+    // The request consists of the kind of the request, the working directory, and the tokens
+    // (the last one is the token to be completed).
+    Vector<String> fields = {"complete", get_cwd()};
+    for (const StringX& elem : tokens)
+        if ((elem.size() > 0) and (elem[0].value != ' '))
+            fields.push_back(elem.string());
+
+    if ((tokens.size() == 0) or (tokens.back().size() == 0) or (tokens.back()[0].value == ' '))
+        fields.push_back("");
+
+    String key = option + "\t";
+    for (const String& field : fields)
+        key += CoProc::escape(field) + "\t";
+
+    // Do nothing until the plugin answers, unless the plugin already answered nothing to the
+    // same request.
+    String output;
+    if ((key != this->plugin_empty) and (not this->request(option, output, fields)))
+        return;
+
+    // Fall back to the default completion if the plugin answered nothing (e.g. the plugin does
+    // not know the command, or exited).
+    if (output.empty())
+    {
+        this->plugin_empty = key;
+
+        if (this->query.starts_with('-')) this->cands_option(tokens);
+        else                              this->cands_filepath(tokens);
+        return;
+    }
+
+    this->plugin_empty.clear();
+
+    for (const String& line : split(output, "\n"))
+    {
+        // Each line is a candidate and its optional description separated by TAB.
+        const size_t pos  = line.find('\t');
+        const String cand = strip(line.substr(0, pos));
+        const String desc = (pos == String::npos) ? String("") : strip(line.substr(pos + 1));
+
+        if (cand.empty() or (not this->matches(cand)))
+            continue;
+
+        this->cands.emplace_back(cand, desc.empty() ? cand : "\x1B[32m" + cand + "\x1B[m  " + desc);
+        this->keys.push_back(cand);
+    }
 
 }   // }}}
 
@@ -428,16 +981,40 @@ void EditHelper::cands_preview(const Vector<StringX>& tokens) noexcept
 
 }   // }}}
 
-void EditHelper::cands_shell(const Vector<StringX>& tokens, const String& option) noexcept
+void EditHelper::cands_shell(const Vector<StringX>& tokens, const String& option, float ttl, const Vector<String>& watch) noexcept
 {   // {{{
 
     // Get the target token.
     const StringX token = (tokens.size() > 0) ? tokens.back().strip() : StringX("");
+    this->query = token.string();
+
+    // The output depends on the working directory (e.g. git branches).
+    const String cwd   = get_cwd();
+    const String key   = option + '\n' + cwd;
+    const String stamp = get_watch_stamp(watch, cwd);
+    const auto   now   = std::chrono::steady_clock::now();
+
+    String output;
 
-    // Run specified command.
-    const String output = run_command(option);
+    // Use the cached output if not expired and the watched files are not modified.
+    const auto iter = shell_outputs.find(key);
+    if ((iter != shell_outputs.end()) and (now < iter->second.expire) and (iter->second.stamp == stamp))
+        output = iter->second.output;
 
-    for (String line : split(output, "\n"))
+    // Otherwise, run specified command. Do nothing until the command finishes on the worker thread.
+    else
+    {
+        if (not this->request(option, output))
+            return;
+
+        // Drop the expired outputs, and cache the new output.
+        std::erase_if(shell_outputs, [now](const auto& item) noexcept { return item.second.expire <= now; });
+
+        if (ttl > 0)
+            shell_outputs[key] = {output, now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(ttl)), stamp};
+    }
+
+    for (String line : split(strip(output), "\n"))
     {
         // Strip line.
         line = strip(line);
@@ -446,8 +1023,11 @@ void EditHelper::cands_shell(const Vector<StringX>& tokens, const String& option
         const StringX line_1st_token = StringX(split(line, " ")[0].c_str());
 
         // Register matched output lines.
-        if (line_1st_token.startswith(token))
-            this->cands.emplace_back(line_1st_token, line.c_str());
+        if (this->matches(line_1st_token.string()))
+        {
+            this->cands.emplace_back(line_1st_token.string(), line);
+            this->keys.push_back(line_1st_token.string());
+        }
     }
 
 }   // }}}
@@ -457,6 +1037,7 @@ void EditHelper::cands_subcmd(const Vector<StringX>& tokens, const String& optio
 
     // Get the target token.
     const StringX token = (tokens.size() > 0) ? tokens.back().strip() : StringX("");
+    this->query = token.string();
 
     // Cache of the command options.
     static Map<String, Vector<StringX>> subcmd_cache;
@@ -465,24 +1046,29 @@ void EditHelper::cands_subcmd(const Vector<StringX>& tokens, const String& optio
     // if the given command is not registered in the cache.
     if (not subcmd_cache.contains(option))
     {
+        // Run command on the worker thread, and do nothing until the command finishes.
+        String output;
+        if (not this->request(option, output))
+            return;
+
         // Initialize the result vector.
         subcmd_cache[option] = Vector<StringX>();
 
-        // Run command and register each line.
-        for (const String& line : split(run_command(option), "\n"))
+        // Register each line.
+        for (const String& line : split(strip(output), "\n"))
             subcmd_cache[option].push_back(StringX(line.c_str()).strip());
     }
 
     for (const StringX& line : subcmd_cache[option])
     {
-        if (line.startswith(token))
-        {
-            // Tokenize a line of the commend result.
-            const Vector<StringX> elems = line.tokenize();
+        // Tokenize a line of the commend result.
+        const Vector<StringX> elems = line.tokenize();
 
-            // Do nothing if no element found.
-            if (elems.size() == 0) continue;
+        // Do nothing if no element found.
+        if (elems.size() == 0) continue;
 
+        if (this->matches(elems[0].string()))
+        {
             // Get completion candidate.
             StringX token1 = StringX("\x1B[32m") + elems[0] + StringX("\x1B[m");
 
@@ -497,23 +1083,227 @@ void EditHelper::cands_subcmd(const Vector<StringX>& tokens, const String& optio
             // Create separator between completion candidate and description.
             const StringX separator = StringX(" ") + CharX('.') * width_seperator + StringX(" ");
 
-            this->cands.emplace_back(elems[0], token1 + separator + token2);
+            this->cands.emplace_back(elems[0].string(), (token1 + separator + token2).string());
+            this->keys.push_back(elems[0].string());
         }
     }
 
 }   // }}}
 
-void EditHelper::lines_from_cands(const Vector<Pair<StringX, StringX>>& cands) noexcept
+bool EditHelper::request(const String& command, String& output, const Vector<String>& fields) noexcept
+{   // {{{
+
+    this->requested = true;
+
+    // The request to the plugin is identified by its fields.
+    const String plugin = (fields.size() > 0) ? command : String("");
+
+    String key = (fields.size() > 0) ? String("") : command;
+    for (const String& field : fields)
+        key += CoProc::escape(field) + "\t";
+
+    // Cancel the previous request if the command is changed.
+    if ((this->request_id != 0) and ((this->request_cmd != key) or (this->request_plugin != plugin)))
+        this->cancel_request();
+
+    // Submit a new request. The request of the same command is shared if still running.
+    if (this->request_id == 0)
+    {
+        this->request_id     = plugin.empty() ? get_providers().submit(command) : get_coproc(plugin, config.plugin_timeout).submit(fields);
+        this->request_cmd    = key;
+        this->request_plugin = plugin;
+    }
+
+    // Get the output if finished (or finished within the timeout).
+    const float timeout  = this->wait_provider ? (plugin.empty() ? config.provider_timeout : config.plugin_timeout) : 0.0f;
+    const bool  finished = plugin.empty() ? get_providers().poll(this->request_id, timeout, output)
+                                          : get_coproc(plugin, config.plugin_timeout).poll(this->request_id, timeout, output);
+    if (not finished)
+        return false;
+
+    this->request_id = 0;
+    this->request_cmd.clear();
+    this->request_plugin.clear();
+
+    return true;
+
+}   // }}}
+
+void EditHelper::cancel_request(void) noexcept
+{   // {{{
+
+    if ((this->request_id != 0) and this->request_plugin.empty())
+        get_providers().cancel(this->request_id);
+
+    else if (this->request_id != 0)
+        get_coproc(this->request_plugin, config.plugin_timeout).cancel(this->request_id);
+
+    this->request_id = 0;
+    this->request_cmd.clear();
+    this->request_plugin.clear();
+
+}   // }}}
+
+bool EditHelper::matches(std::string_view key) const noexcept
+{   // {{{
+
+    if (config.fuzzy_completion)
+        return HistSearch::score(key, this->query) >= 0;
+
+    return key.starts_with(this->query);
+
+}   // }}}
+
+void EditHelper::rank_cands(void) noexcept
 {   // {{{
 
-    // Get descriptions of the completion candidates.
-    constexpr auto get_second = [](const Pair<StringX, StringX>& pair) noexcept -> StringX { return pair.second; };
-    Vector<StringX> texts = transform<Pair<StringX, StringX>, StringX>(cands, get_second);
+    // Sort the candidates by the score, where the candidates of the same score keep the order
+    // (e.g. directories first).
+    Vector<Pair<int32_t, uint32_t>> scored;
+    for (uint32_t idx = 0; idx < this->keys.size(); ++idx)
+        scored.emplace_back(HistSearch::score(this->keys[idx], this->query), idx);
+
+    const size_t n_selected = select_best(scored, config.completion_max_cands);
+
+    // Compute the common prefix of all candidates before dropping the hidden ones.
+    if ((n_selected < scored.size()) and (this->n_total <= this->cands.size()))
+    {
+        const std::string_view first = this->cands[0].first;
+
+        size_t n_common = first.size();
+        for (const auto& cand : this->cands)
+            n_common = get_common_size(first.substr(0, n_common), cand.first);
+
+        this->n_total = this->cands.size();
+        this->common  = String(first.substr(0, n_common));
+    }
+
+    Vector<Pair<String, String>> cands;
+    Vector<String>               keys;
+    for (size_t n = 0; n < n_selected; ++n)
+    {
+        cands.push_back(std::move(this->cands[scored[n].second]));
+        keys .push_back(std::move(this->keys [scored[n].second]));
+    }
+
+    this->cands = std::move(cands);
+    this->keys  = std::move(keys);
+
+}   // }}}
+
+uint32_t EditHelper::max_visible(void) const noexcept
+{   // {{{
+
+    // Each column is at least one character and the margin (3 characters) wide.
+    return static_cast<uint32_t>(this->area.rows) * (this->area.cols / 4 + 1);
+
+}   // }}}
+
+bool EditHelper::narrow_cands(const StringX& lhs, CompType comp_type, const String& option) noexcept
+{   // {{{
+
+    // The candidates are recomputed until the pending provider finishes, and also if they are
+    // capped (the hidden candidates may match the extended query).
+    if ((this->request_id != 0) or (this->n_total > this->cands.size()))
+        return false;
+
+    // The recursive candidates are matched by the path components, and may be incomplete.
+    if (this->walker != nullptr)
+        return false;
+
+    const auto& [lhs_prev, comp_type_prev, option_prev] = this->context;
+
+    // The candidates are recomputed if the completion target is changed, or the characters are
+    // deleted (e.g. backspace) or inserted at the other place (e.g. cursor jump).
+    if ((comp_type != comp_type_prev) or (option != option_prev) or (lhs.size() <= lhs_prev.size()) or (not lhs.startswith(lhs_prev)))
+        return false;
+
+    // The candidates of an empty query may exclude some candidates (e.g. dot files), and the
+    // query of the preview depends on the existence of the file.
+    if ((this->query.size() == 0) or (comp_type == EditHelper::CompType::PREVIEW))
+        return false;
+
+    // The appended characters should extend the last token without changing the directory.
+    const StringX appended = lhs.substr(lhs_prev.size());
+    for (const CharX& cx : appended)
+        if ((cx.value == ' ') or (cx.value == '/') or (cx.value == '\\') or (cx.value == '\'') or (cx.value == '"'))
+            return false;
+
+    // Filter the current candidates by the extended query.
+    this->query += appended.string();
+
+    size_t n_kept = 0;
+    for (size_t idx = 0; idx < this->cands.size(); ++idx)
+    {
+        if (this->matches(this->keys[idx]))
+        {
+            this->cands[n_kept] = this->cands[idx];
+            this->keys [n_kept] = this->keys [idx];
+            ++n_kept;
+        }
+    }
+    this->cands.resize(n_kept);
+    this->keys.resize(n_kept);
+    this->n_total = n_kept;
+
+    this->context = {lhs, comp_type, option};
+
+    return true;
+
+}   // }}}
+
+String EditHelper::describe(size_t index) const noexcept
+{   // {{{
+
+    // The path candidates are colorized here, and the others have the display strings.
+    const String desc = this->cands_dir.empty() ? this->cands[index].second : colorize_path(PathX(this->cands_dir), this->keys[index]);
+
+    // Decorate the characters matched with the query of the fuzzy matching, where the key is
+    // searched in the description which may contain colors and explanations.
+    if ((not config.fuzzy_completion) or (this->query.size() == 0))
+        return desc;
+
+    const size_t offset = desc.find(this->keys[index]);
+
+    Vector<uint16_t> positions;
+    if ((offset == String::npos) or (HistSearch::score(this->keys[index], this->query, &positions) < 0))
+        return desc;
+
+    return highlight(desc, positions, config.fuzzy_match_pre, config.fuzzy_match_post, offset);
+
+}   // }}}
+
+void EditHelper::lines_from_cands(const Vector<Pair<String, String>>& cands) noexcept
+{   // {{{
+
+    // Index of the first candidate of the current page.
+    const size_t idx_bgn = std::min(this->pages.back(), cands.size());
+
+    // Format only the candidates which can be shown in the current page.
+    const size_t idx_end = std::min(idx_bgn + this->max_visible(), cands.size());
+
+    Vector<StringX> texts;
+    for (size_t idx = idx_bgn; idx < idx_end; ++idx)
+        texts.push_back(StringX(this->describe(idx).c_str()));
+
+    // Format descriptions in a column style. If not all candidates can be shown, the last line
+    // is used for the indicator of the hidden candidates.
+    const size_t n_total = std::max(this->n_total, cands.size());
+    size_t       n_shown = 0;
+
+    this->lines = column(texts, this->area.cols, this->area.rows, 3, &n_shown);
+
+    if ((n_shown < n_total - idx_bgn) and (this->area.rows > 1))
+    {
+        this->lines = column(texts, this->area.cols, this->area.rows - 1, 3, &n_shown);
+
+        const String indicator = std::to_string(idx_bgn + 1) + "-" + std::to_string(idx_bgn + n_shown) + " of " + std::to_string(n_total) + ", "
+                               + std::to_string(n_total - idx_bgn - n_shown) + " more (PageUp/PageDown)";
+
+        this->lines.push_back(StringX((config.pager_pre + indicator + config.pager_post).c_str()));
+    }
 
-    // Format descriptions in a column style.
-    this->lines.clear();
-    for (const StringX& line : column(texts, this->area.cols, this->area.rows))
-        this->lines.push_back(line);
+    this->page_size = n_shown;
 
     // Add decoration at the left line and clip line width.
     for (size_t i = 0; i < this->lines.size(); ++i)
@@ -8,7 +8,13 @@
 #ifndef EDIT_HELPER_HXX
 #define EDIT_HELPER_HXX
 
+// Include the headers of STL.
+#include <memory>
+#include <string_view>
+
 // Include the headers of custom modules.
+#include "cmd_index.hxx"
+#include "dir_walker.hxx"
 #include "dtypes.hxx"
 #include "string_x.hxx"
 
@@ -24,7 +30,7 @@ class EditHelper
         // Data types
         ////////////////////////////////////////////////////////////////////////////////////////////
 
-        enum class CompType { COMMAND, OPTION, PATH, PREVIEW, SHELL, SUBCMD, NONE };
+        enum class CompType { COMMAND, OPTION, PATH, PLUGIN, PREVIEW, SHELL, SUBCMD, NONE };
 
         ////////////////////////////////////////////////////////////////////////////////////////////
         // Constructors and destructors
@@ -37,20 +43,62 @@ class EditHelper
         // [Args]
         //   height (uint16_t): [IN] height of completion area.
 
+        ~EditHelper(void);
+        // [Abstract]
+        //   Destructor of EditHelper. The pending provider request is cancelled.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Static functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        static void prefetch_commands(void) noexcept;
+        // [Abstract]
+        //   Start scanning available command names on a worker thread.
+        //   The result will be used by the next EditHelper instance.
+
+        static void prefetch_options(const Deque<StringX>& hists) noexcept;
+        // [Abstract]
+        //   Start parsing the options of the most frequent commands in the histories on a worker
+        //   thread, and store them to the option cache file. Only the commands which are found in
+        //   PATH and used with options in the histories are parsed.
+        //
+        // [Args]
+        //   hists (const Deque<StringX>&): [IN] Histories.
+
         ////////////////////////////////////////////////////////////////////////////////////////////
         // Member functions
         ////////////////////////////////////////////////////////////////////////////////////////////
 
-        Vector<StringX> candidate(const StringX& lhs) noexcept;
+        Vector<StringX> candidate(const StringX& lhs, bool wait = true) noexcept;
         // [Abstract]
         //   Returns condidates of completion.
+        //   The shell commands of completion providers (e.g. SHELL) run on worker threads. If
+        //   `wait` is false and the provider has not finished yet, the previous candidates are
+        //   returned, and `is_ready` becomes true when the provider finished.
         //
         // [Args]
-        //   lhs (const StringX&): [IN] Left-hand-side of the user input.
+        //   lhs  (const StringX&): [IN] Left-hand-side of the user input.
+        //   wait (bool)          : [IN] Wait for the provider at most `config.provider_timeout` seconds.
+        //
+        // [Returns]
+        //   (std::vector<StringX>): Array of lines (strings) for showing completion candidates to users.
+
+        Vector<StringX> scroll(int8_t n_pages) noexcept;
+        // [Abstract]
+        //   Show the next pages (positive) or the previous pages (negative) of the current
+        //   completion candidates. Only the candidates in the shown page are formatted.
+        //
+        // [Args]
+        //   n_pages (int8_t): [IN] Number of pages to scroll.
         //
         // [Returns]
         //   (std::vector<StringX>): Array of lines (strings) for showing completion candidates to users.
 
+        bool is_ready(void) noexcept;
+        // [Abstract]
+        //   Returns true if the pending provider finished, i.e. the candidates should be
+        //   recomputed by calling `candidate` again.
+
         StringX complete(const StringX& lhs) const noexcept;
         // [Abstract]
         //   Execute completion.
@@ -71,14 +119,75 @@ class EditHelper
         TermSize area;
         // Size of drawing area.
 
-        Vector<Pair<StringX, StringX>> cands;
-        // Completion candidates.
+        Vector<Pair<String, String>> cands;
+        // Completion candidates, i.e. pairs of the completion string and display string.
+
+        Vector<String> keys;
+        // Strings which are matched with the query for each completion candidate.
+
+        size_t n_total;
+        // Number of all matched candidates, which is larger than the size of `cands` if the
+        // candidates are capped to the ones which can be shown in the drawing area.
+
+        String common;
+        // Common prefix of all matched candidates (used only if the candidates are capped).
+
+        Path cands_dir;
+        // Directory of the path candidates, whose display strings are colorized when shown
+        // (empty for the other completion types).
+
+        String query;
+        // Query of the current completion candidates.
+
+        Tuple<StringX, CompType, String> context;
+        // Left-hand-side, completion type, and optional string of the current completion candidates.
+
+        bool has_context;
+        // True if the context is set, i.e. the candidates are computed at least once.
+
+        Vector<size_t> pages;
+        // Indices of the first candidates of the shown page and its previous pages.
+
+        size_t page_size;
+        // Number of the candidates in the shown page.
 
         Vector<StringX> lines;
         // Completion lines.
 
-        Vector<StringX> cache_commands;
-        // Cache of available command names.
+        CmdIndex::Commands cache_commands;
+        // Available command names shared with the command index.
+
+        uint64_t request_id;
+        // ID of the pending provider request (zero if nothing is pending).
+
+        String request_cmd;
+        // Shell command (or fields for the plugin) of the pending provider request.
+
+        String request_plugin;
+        // Plugin of the pending provider request (empty if the request is sent to the worker pool).
+
+        bool requested;
+        // True if a provider request is made while computing the current candidates.
+
+        String plugin_empty;
+        // Fields of the last plugin request answered with nothing. The default completion is used
+        // for the same fields without asking the plugin again, so that the request of the default
+        // completion is not cancelled by the plugin request at the next call.
+
+        bool wait_provider;
+        // True if the current computation of candidates waits for the provider.
+
+        std::unique_ptr<DirWalker> walker;
+        // Directory walker of the recursive path completion (null if not used).
+
+        Vector<String> walked;
+        // Entries fetched from the directory walker.
+
+        bool walk_done;
+        // True if the walk finished and all entries are fetched.
+
+        bool walk_used;
+        // True if the directory walker is used while computing the current candidates.
 
         ////////////////////////////////////////////////////////////////////////////////////////////
         // Private functions
@@ -102,6 +211,17 @@ class EditHelper
         // [Args]
         //   tokens (const std::vector<StringX>&): [IN] Parsed tokens of the user input.
 
+        void cands_recursive(const String& token, size_t pos) noexcept;
+        // [Abstract]
+        //   Compute file path completion candidates under the directory before "**", where the
+        //   paths which have a component starting with the string after "**" are matched. The
+        //   entries found so far are used if the walk is not finished.
+        //   The result candidates will be stored in `this->cands`.
+        //
+        // [Args]
+        //   token (const String&): [IN] Last token of the user input.
+        //   pos   (size_t)       : [IN] Position of "**" in the token.
+
         void cands_option(const Vector<StringX>& tokens) noexcept;
         // [Abstract]
         //   Compute command option candidates.
@@ -110,6 +230,18 @@ class EditHelper
         // [Args]
         //   tokens (const std::vector<StringX>&): [IN] Parsed tokens of the user input.
 
+        void cands_plugin(const Vector<StringX>& tokens, const String& option) noexcept;
+        // [Abstract]
+        //   Compute completion candidates from the plugin running as a persistent coprocess.
+        //   The plugin receives the working directory and the tokens, and answers the candidates
+        //   line by line, where each line is a candidate optionally followed by TAB and its
+        //   description. The candidates are computed as PATH (or OPTION if the token starts with
+        //   "-") if the plugin answered nothing.
+        //
+        // [Args]
+        //   tokens (const std::vector<StringX>&): [IN] Parsed tokens of the user input.
+        //   option (const std::string&)         : [IN] Shell command to start the plugin.
+
         void cands_preview(const Vector<StringX>& tokens) noexcept;
         // [Abstract]
         //   Compute completion candidates for preview.
@@ -118,13 +250,16 @@ class EditHelper
         //   tokens (const std::vector<StringX>&): [IN] Parsed tokens of the user input.
         //   option (const std::string)          : [IN] Optional string for the preview.
 
-        void cands_shell(const Vector<StringX>& tokens, const String& option) noexcept;
+        void cands_shell(const Vector<StringX>& tokens, const String& option, float ttl, const Vector<String>& watch) noexcept;
         // [Abstract]
         //   Compute completion candidates from shell command.
+        //   The output of the command is cached for each working directory.
         //
         // [Args]
         //   tokens (const std::vector<StringX>&): [IN] Parsed tokens of the user input.
         //   option (const std::string&)         : [IN] Optional string (normally it is a shell command).
+        //   ttl    (float)                      : [IN] Time-to-live of the cached output in seconds.
+        //   watch  (const Vector<String>&)      : [IN] Files whose modification invalidates the cached output.
 
         void cands_subcmd(const Vector<StringX>& tokens, const String& option) noexcept;
         // [Abstract]
@@ -134,12 +269,77 @@ class EditHelper
         //   tokens (const std::vector<StringX>&): [IN] Parsed tokens of the user input.
         //   option (const std::string&)         : [IN] Optional string.
 
-        void lines_from_cands(const Vector<Pair<StringX, StringX>>& cands) noexcept;
+        bool request(const String& command, String& output, const Vector<String>& fields = {}) noexcept;
+        // [Abstract]
+        //   Request the output of the shell command to the worker pool, or send the fields to the
+        //   plugin if the fields are given. The previous request is cancelled if the command or
+        //   the fields differ (its output is no longer needed).
+        //
+        // [Args]
+        //   command (const String&)        : [IN ] Shell command, or the command to start the plugin.
+        //   output  (String&)              : [OUT] Output of the command.
+        //   fields  (const Vector<String>&): [IN ] Fields of the request to the plugin.
+        //
+        // [Returns]
+        //   (bool): True if the output is available, false if the command is still running.
+
+        void cancel_request(void) noexcept;
+        // [Abstract]
+        //   Cancel the pending provider request if exists.
+
+        bool matches(std::string_view key) const noexcept;
+        // [Abstract]
+        //   Returns true if the key matches the current query, that is, the key starts with the
+        //   query, or contains the query as a subsequence if the fuzzy completion is enabled.
+        //
+        // [Args]
+        //   key (std::string_view): [IN] Key of a completion candidate.
+        //
+        // [Returns]
+        //   (bool): True if the key matches the query.
+
+        void rank_cands(void) noexcept;
+        // [Abstract]
+        //   Sort the current completion candidates in descending order of the fuzzy matching
+        //   score, and keep the candidates which can be shown in the drawing area.
+
+        uint32_t max_visible(void) const noexcept;
+        // [Abstract]
+        //   Returns the maximum number of candidates which can be shown in the drawing area.
+
+        bool narrow_cands(const StringX& lhs, CompType comp_type, const String& option) noexcept;
+        // [Abstract]
+        //   Narrow the current completion candidates if the given input extends the input of the
+        //   current candidates, i.e. only non-separator characters are appended to the last token.
+        //   The candidates whose keys do not match the extended query are removed.
+        //
+        // [Args]
+        //   lhs       (const StringX&): [IN] Left-hand-side of the user input.
+        //   comp_type (CompType)      : [IN] Completion type.
+        //   option    (const String&) : [IN] Optional string of the completion.
+        //
+        // [Returns]
+        //   (bool): True if the candidates are narrowed, false if they should be recomputed.
+
+        String describe(size_t index) const noexcept;
+        // [Abstract]
+        //   Returns the display string of the candidate. The matched characters are decorated if
+        //   the fuzzy completion is enabled.
+        //
+        // [Args]
+        //   index (size_t): [IN] Index of the candidate.
+        //
+        // [Returns]
+        //   (String): Display string of the candidate.
+
+        void lines_from_cands(const Vector<Pair<String, String>>& cands) noexcept;
         // [Abstract]
-        //   Convert candidate to strings that will be shown to users.
+        //   Convert candidate to strings that will be shown to users. Only the candidates in the
+        //   current page are formatted, and the last line shows the number of the hidden
+        //   candidates if not all candidates can be shown.
         //
         // [Args]
-        //   cands (const std::vector<std::pair<StringX, StringX>>&): [IN] Completion candidates.
+        //   cands (const std::vector<std::pair<String, String>>&): [IN] Completion candidates.
         //
         // [Returns]
         //   (std::vector<StringX>): Array of lines (strings) for showing completion candidates to users.
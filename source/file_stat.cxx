@@ -0,0 +1,175 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ source file: file_stat.cxx                                                               ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Include the primary header.
+#include "file_stat.hxx"
+
+// Include the headers of STL.
+#include <chrono>
+#include <mutex>
+#include <sys/stat.h>
+
+// Include the headers of custom modules.
+#include "config.hxx"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Static variables
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef struct CacheEntry
+{
+    FileStat stat;       // Cached metadata.
+    int64_t  dir_mtime;  // Modification time of the parent directory when the metadata was read.
+    int64_t  time_read;  // Wall-clock time when the metadata was read (nanoseconds).
+    std::chrono::steady_clock::time_point time_checked;  // Time when the entry was validated.
+}
+CacheEntry;
+// Entry of the file metadata cache.
+
+static constexpr size_t MAX_CACHED_FILES = 1 << 14;
+// The maximum number of cached files. The entries older than `stat_cache_max_age` are dropped
+// when exceeded, and the whole cache is dropped if it is still more than half full.
+
+static Map<String, CacheEntry> cache;
+// Cache of the file metadata where the key is the absolute file path.
+
+static std::mutex cache_mutex;
+// Mutex for the cache.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Static functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static FileStat read_file_stat(const String& path) noexcept
+// [Abstract]
+//   Read metadata of the given file by the stat system call.
+//
+// [Args]
+//   path (const String&): [IN] Path to the target file.
+//
+// [Returns]
+//   (FileStat): Metadata of the file.
+//
+{   // {{{
+
+    struct stat st;
+
+    if (::stat(path.c_str(), &st) != 0)
+        return {false, false, false, 0};
+
+    const int64_t mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+
+    return {true, S_ISDIR(st.st_mode), (st.st_mode & S_IXUSR) != 0, mtime};
+
+}   // }}}
+
+static int64_t now_ns(void) noexcept
+// [Abstract]
+//   Returns the current wall-clock time in nanoseconds since the epoch.
+//
+{   // {{{
+
+    const auto now = std::chrono::system_clock::now().time_since_epoch();
+
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+
+}   // }}}
+
+static FileStat lookup(const String& path, uint8_t depth) noexcept
+// [Abstract]
+//   Get metadata of the file from the cache. The cache mutex should be locked by the caller.
+//
+// [Args]
+//   path  (const String&): [IN] Path to the target file.
+//   depth (uint8_t)      : [IN] Recursion depth (0 for the target, 1 for its parent directory).
+//
+// [Returns]
+//   (FileStat): Metadata of the file.
+//
+{   // {{{
+
+    using seconds = std::chrono::duration<double>;
+
+    const auto now = std::chrono::steady_clock::now();
+
+    // Case 1: the entry was validated recently => trust it without any system call.
+    auto iter = cache.find(path);
+    if ((iter != cache.end()) and (seconds(now - iter->second.time_checked).count() < config.stat_cache_ttl))
+        return iter->second.stat;
+
+    // Get the modification time of the parent directory. It is also cached, therefore the
+    // directory is read only once per TTL even if it contains many entries. Note that the
+    // directory itself is never revalidated by its own parent because the modification time
+    // of a directory does not propagate to its parent.
+    const String  parent    = Path(path).parent_path().string();
+    const bool    has_dir   = (depth == 0) and (parent.size() > 0) and (parent != path);
+    const int64_t dir_mtime = has_dir ? lookup(parent, depth + 1).mtime : 0;
+
+    // Case 2: the parent directory is not modified => the entry is still valid. The entry is
+    // trusted only if it was read well after the directory modification because the time
+    // stamps of some file systems are coarse (at most one second).
+    iter = cache.find(path);
+    if ((iter != cache.end()) and has_dir and (dir_mtime != 0) and (dir_mtime == iter->second.dir_mtime) and
+        (iter->second.time_read - dir_mtime > 1000000000) and
+        (now_ns() - iter->second.time_read < static_cast<int64_t>(config.stat_cache_max_age * 1e9)))
+    {
+        iter->second.time_checked = now;
+        return iter->second.stat;
+    }
+
+    // Case 3: otherwise, read the metadata again.
+    const FileStat stat = read_file_stat(path);
+    cache[path] = {stat, dir_mtime, now_ns(), now};
+
+    // Drop the entries which would be read again anyway if too many files are cached. The cache
+    // is cleared if most entries are fresh, so that the entries are not scanned at every miss.
+    if (cache.size() > MAX_CACHED_FILES)
+    {
+        const int64_t time_expired = now_ns() - static_cast<int64_t>(config.stat_cache_max_age * 1e9);
+        std::erase_if(cache, [time_expired](const auto& item) noexcept { return item.second.time_read < time_expired; });
+
+        if (cache.size() > MAX_CACHED_FILES / 2)
+            cache.clear();
+    }
+
+    return stat;
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Published functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FileStat get_file_stat(const Path& path) noexcept
+{   // {{{
+
+    // Normalize the path to the absolute path so that the same file shares the same cache entry,
+    // and the relative paths are not confused after changing the working directory.
+    if (path.empty())
+        return {false, false, false, 0};
+
+    std::error_code ec;
+    String key = std::filesystem::absolute(path, ec).lexically_normal().string();
+    if ((key.size() > 1) and (key.back() == '/'))
+        key.pop_back();
+
+    if (key.size() == 0)
+        return {false, false, false, 0};
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+
+    return lookup(key, 0);
+
+}   // }}}
+
+void clear_file_stat_cache(void) noexcept
+{   // {{{
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+
+    cache.clear();
+
+}   // }}}
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
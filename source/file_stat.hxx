@@ -0,0 +1,53 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ header file: file_stat.hxx                                                               ///
+///                                                                                              ///
+/// This file defines the functions to get file metadata through a short-lived cache which is    ///
+/// shared by the completion and preview. A cached entry is trusted for a short time, and after  ///
+/// that it is revalidated by the modification time of its parent directory, so that only one    ///
+/// system call per directory is needed on slow file systems (e.g. NFS or sshfs).                ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef FILE_STAT_HXX
+#define FILE_STAT_HXX
+
+// Include the headers of STL.
+#include <cstdint>
+
+// Include the headers of custom modules.
+#include "dtypes.hxx"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Structs
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef struct FileStat
+{
+    bool    exists;   // True if the file exists.
+    bool    is_dir;   // True if the file is a directory.
+    bool    is_exec;  // True if the file is executable by the owner.
+    int64_t mtime;    // Modification time in nanoseconds since the epoch.
+}
+FileStat;
+// Metadata of a file (symbolic links are followed).
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Published functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FileStat get_file_stat(const Path& path) noexcept;
+// [Abstract]
+//   Get metadata of the given file through the cache. This function is thread-safe.
+//
+// [Args]
+//   path (const Path&): [IN] Path to the target file.
+//
+// [Returns]
+//   (FileStat): Metadata of the file.
+
+void clear_file_stat_cache(void) noexcept;
+// [Abstract]
+//   Clear all cached file metadata.
+
+#endif
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
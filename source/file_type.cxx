@@ -6,10 +6,12 @@
 #include "file_type.hxx"
 
 // Include the headers of STL.
-#include <filesystem>
 #include <fnmatch.h>
 #include <fstream>
 
+// Include the headers of custom modules.
+#include "file_stat.hxx"
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // FileType: Constructors
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -54,7 +56,7 @@ String FileType::mime(const String& path) const noexcept
 {   // {{{
 
     // Do nothing if the path is not a file.
-    if (std::filesystem::is_directory(path))
+    if (get_file_stat(path).is_dir)
         return "inode/directory";
 
     // Get file name as a preprocessing for pattern matching.
@@ -0,0 +1,349 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ source file: git_index.cxx                                                               ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Include the primary header.
+#include "git_index.hxx"
+
+// Include the headers of STL.
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Include the headers of custom modules.
+#include "utils.hxx"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Static functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t read_be32(const uint8_t* ptr) noexcept
+// [Abstract]
+//   Returns the 32-bit big-endian integer at the given address.
+//
+{   // {{{
+
+    return (static_cast<uint32_t>(ptr[0]) << 24) | (static_cast<uint32_t>(ptr[1]) << 16) | (static_cast<uint32_t>(ptr[2]) << 8) | static_cast<uint32_t>(ptr[3]);
+
+}   // }}}
+
+static GitIndex::Tracked parse_entries(const uint8_t* data, size_t size) noexcept
+// [Abstract]
+//   Parse the entries of the index file.
+//
+// [Args]
+//   data (const uint8_t*): [IN] Contents of the index file.
+//   size (size_t)        : [IN] Size of the index file.
+//
+// [Returns]
+//   (GitIndex::Tracked): Tracked paths (null if the index file is broken or not supported).
+//
+{   // {{{
+
+    // Offset of the flags in an entry (ctime, mtime, dev, ino, mode, uid, gid, size, and SHA-1).
+    constexpr size_t OFFSET_FLAGS = 60;
+
+    // Header: signature, version, and number of entries.
+    if ((size < 12) or (std::memcmp(data, "DIRC", 4) != 0))
+        return nullptr;
+
+    const uint32_t version   = read_be32(data + 4);
+    const uint32_t n_entries = read_be32(data + 8);
+
+    if ((version < 2) or (version > 4))
+        return nullptr;
+
+    std::shared_ptr<GitIndex::Paths> paths = std::make_shared<GitIndex::Paths>();
+    paths->offsets.reserve(n_entries);
+
+    String name;
+    size_t pos = 12;
+
+    for (uint32_t idx = 0; idx < n_entries; ++idx)
+    {
+        const size_t pos_entry = pos;
+
+        if (pos + OFFSET_FLAGS + 2 > size)
+            return nullptr;
+
+        const uint16_t flags = static_cast<uint16_t>((data[pos + OFFSET_FLAGS] << 8) | data[pos + OFFSET_FLAGS + 1]);
+        pos += OFFSET_FLAGS + 2;
+
+        // Extended flags (version 3 or later).
+        uint16_t flags_ext = 0;
+        if (flags & 0x4000)
+        {
+            if ((version < 3) or (pos + 2 > size))
+                return nullptr;
+
+            flags_ext = static_cast<uint16_t>((data[pos] << 8) | data[pos + 1]);
+            pos += 2;
+        }
+
+        // The path of the version 4 is compressed by removing the prefix shared with the previous
+        // path, where the number of the removed bytes from the previous path is stored.
+        if (version == 4)
+        {
+            size_t n_strip = 0;
+            for (bool first = true; true; first = false)
+            {
+                if (pos >= size)
+                    return nullptr;
+
+                const uint8_t byte = data[pos++];
+                n_strip = (first ? 0 : ((n_strip + 1) << 7)) | (byte & 0x7F);
+
+                if ((byte & 0x80) == 0)
+                    break;
+            }
+
+            if (n_strip > name.size())
+                return nullptr;
+
+            name.resize(name.size() - n_strip);
+        }
+        else name.clear();
+
+        const uint8_t* end = static_cast<const uint8_t*>(std::memchr(data + pos, '\0', size - pos));
+        if (end == nullptr)
+            return nullptr;
+
+        name.append(reinterpret_cast<const char*>(data + pos), end - (data + pos));
+        pos = end - data + 1;
+
+        // The entries of the version 2 and 3 are padded to a multiple of 8 bytes, and the length
+        // of the name is stored in the flags, which detects the entries of unsupported formats
+        // (e.g. SHA-256 repositories).
+        if (version < 4)
+        {
+            const size_t len = end - (data + pos_entry) - (OFFSET_FLAGS + 2) - ((flags & 0x4000) ? 2 : 0);
+
+            if (((flags & 0x0FFF) < 0x0FFF) and ((flags & 0x0FFF) != len))
+                return nullptr;
+
+            pos = pos_entry + ((end - (data + pos_entry) + 8) & ~static_cast<size_t>(7));
+        }
+
+        // Skip the files which are not checked out by the sparse checkout, the directories of
+        // the sparse index, and the conflicted stages of the same path.
+        if ((flags_ext & 0x4000) or name.ends_with('/'))
+            continue;
+
+        if ((paths->offsets.size() > 0) and (GitIndex::path(*paths, paths->offsets.size() - 1) == name))
+            continue;
+
+        paths->offsets.push_back(static_cast<uint32_t>(paths->arena.size()));
+        paths->arena.append(name);
+        paths->arena.push_back('\0');
+    }
+
+    // The entries are sorted by git, but the order is checked because the binary search relies on it.
+    const auto compare = [&paths](uint32_t a, uint32_t b) noexcept -> bool
+    { return std::string_view(paths->arena.data() + a) < std::string_view(paths->arena.data() + b); };
+
+    if (not std::is_sorted(paths->offsets.begin(), paths->offsets.end(), compare))
+        std::sort(paths->offsets.begin(), paths->offsets.end(), compare);
+
+    return paths;
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// GitIndex: Constructors
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+GitIndex::GitIndex(void)
+{ /* Do nothing */ }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// GitIndex: Member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool GitIndex::list(const Path& dir, const String& prefix, uint32_t n_max_items, bool show_dot, Vector<String>& names) noexcept
+{   // {{{
+
+    // Get the relative path of the directory from the top of the work tree.
+    std::error_code ec;
+    Path dir_abs = std::filesystem::weakly_canonical(std::filesystem::absolute(dir.empty() ? Path(".") : dir, ec), ec);
+    if (ec)
+        return false;
+
+    if (dir_abs.filename().empty())
+        dir_abs = dir_abs.parent_path();
+
+    const Path top = GitIndex::find_top(dir_abs);
+    if (top.empty())
+        return false;
+
+    const String rel = (dir_abs == top) ? String("") : dir_abs.lexically_relative(top).string() + "/";
+    if (rel.starts_with(".git/") or rel.starts_with("../"))
+        return false;
+
+    const Tracked tracked = this->get(top);
+    if (tracked == nullptr)
+        return false;
+
+    const Paths& paths = *tracked;
+
+    const auto lower_bound = [&paths](Vector<uint32_t>::const_iterator iter, const String& key) noexcept
+    {
+        return std::partition_point(iter, paths.offsets.end(), [&](uint32_t offset) noexcept
+        { return std::string_view(paths.arena.data() + offset) < key; });
+    };
+
+    const auto get_path = [&paths](Vector<uint32_t>::const_iterator iter) noexcept -> std::string_view
+    { return std::string_view(paths.arena.data() + *iter); };
+
+    // The directory which has no tracked file (e.g. build outputs) is listed from the file system.
+    const auto iter_dir = lower_bound(paths.offsets.begin(), rel);
+    if ((iter_dir == paths.offsets.end()) or (not get_path(iter_dir).starts_with(rel)))
+        return false;
+
+    // The paths which start with the directory and the prefix are contiguous in the sorted order.
+    Vector<String> dirs, files;
+    for (auto iter = lower_bound(iter_dir, rel + prefix); (iter != paths.offsets.end()) and get_path(iter).starts_with(rel + prefix);)
+    {
+        const std::string_view path = get_path(iter);
+        const size_t           pos  = path.find('/', rel.size());
+        const std::string_view name = path.substr(rel.size(), (pos == std::string_view::npos) ? std::string_view::npos : pos - rel.size() + 1);
+
+        const bool visible = show_dot or (name[0] != '.');
+
+        if (pos == std::string_view::npos)
+        {
+            if (visible) files.emplace_back(name);
+            ++iter;
+            continue;
+        }
+
+        if (visible) dirs.emplace_back(name);
+
+        // Skip the files in the subdirectory, i.e. jump to the first path which is larger than
+        // any path that starts with "<subdir>/" ('0' is the next character of '/').
+        iter = lower_bound(iter, String(path.substr(0, pos)) + "0");
+    }
+
+    // Directories first, and both of them are already sorted.
+    names.clear();
+    for (Vector<String>* group : {&dirs, &files})
+        for (String& name : *group)
+            if (names.size() < n_max_items)
+                names.push_back(std::move(name));
+
+    return true;
+
+}   // }}}
+
+GitIndex::Tracked GitIndex::get(const Path& top) noexcept
+{   // {{{
+
+    const Path path_index = GitIndex::find_index(top);
+
+    struct stat st;
+    if (path_index.empty() or (::stat(path_index.c_str(), &st) != 0))
+        return nullptr;
+
+    // The index file is replaced by rename when it is updated, so the inode also changes.
+    const String stamp = std::to_string(st.st_ino) + ":" + std::to_string(st.st_size) + ":" + std::to_string(st.st_mtim.tv_sec) + "." + std::to_string(st.st_mtim.tv_nsec);
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    Entry& entry = this->repos[top.string()];
+    if (entry.stamp != stamp)
+        entry = {stamp, GitIndex::parse(path_index)};
+
+    return entry.tracked;
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// GitIndex: Static functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Path GitIndex::find_top(const Path& dir) noexcept
+{   // {{{
+
+    std::error_code ec;
+
+    for (Path target = dir; not target.empty(); target = target.parent_path())
+    {
+        if (std::filesystem::exists(target / ".git", ec))
+            return target;
+
+        if (target == target.parent_path())
+            break;
+    }
+
+    return Path();
+
+}   // }}}
+
+GitIndex::Tracked GitIndex::parse(const Path& path) noexcept
+{   // {{{
+
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return nullptr;
+
+    struct stat st;
+    if ((fstat(fd, &st) != 0) or (st.st_size == 0))
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    // Map the index file to the memory instead of reading it, because only the names are used.
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED)
+        return nullptr;
+
+    Tracked tracked = parse_entries(static_cast<const uint8_t*>(data), st.st_size);
+
+    munmap(data, st.st_size);
+
+    return tracked;
+
+}   // }}}
+
+std::string_view GitIndex::path(const Paths& paths, uint32_t index) noexcept
+{   // {{{
+
+    return std::string_view(paths.arena.data() + paths.offsets[index]);
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// GitIndex: Private member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Path GitIndex::find_index(const Path& top) noexcept
+{   // {{{
+
+    const Path path_git = top / ".git";
+
+    struct stat st;
+    if (::stat(path_git.c_str(), &st) != 0)
+        return Path();
+
+    if (S_ISDIR(st.st_mode))
+        return path_git / "index";
+
+    // The ".git" file contains "gitdir: <path to the git directory>".
+    std::ifstream ifs(path_git);
+    String line;
+    if ((not std::getline(ifs, line)) or (not line.starts_with("gitdir:")))
+        return Path();
+
+    const Path git_dir = Path(strip(line.substr(7)));
+
+    return (git_dir.is_absolute() ? git_dir : top / git_dir) / "index";
+
+}   // }}}
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
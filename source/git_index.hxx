@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ header file: git_index.hxx                                                               ///
+///                                                                                              ///
+/// This file defines the class `GitIndex` which lists the files tracked by git for the path     ///
+/// completion in a git work tree, so that build outputs and ignored files are not listed and no ///
+/// file is stat-ed. The index file ".git/index" is mapped to the memory and parsed directly     ///
+/// without running git, and the tracked paths are kept sorted in a contiguous arena until the   ///
+/// index file is modified. The entries of a directory are found by a binary search, and each    ///
+/// subdirectory is skipped by another binary search.                                            ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef GIT_INDEX_HXX
+#define GIT_INDEX_HXX
+
+// Include the headers of STL.
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+// Include the headers of custom modules.
+#include "dtypes.hxx"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Class definitions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class GitIndex
+{
+    public:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Data types
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        typedef struct Paths
+        {
+            String           arena;    // Tracked paths terminated by '\0'.
+            Vector<uint32_t> offsets;  // Offsets of the paths in the arena in the sorted order.
+        }
+        Paths;
+        // Sorted and unique paths of the tracked files relative to the top of the work tree.
+
+        typedef std::shared_ptr<const Paths> Tracked;
+        // Tracked paths which are immutable and shared with the callers. They are replaced by new
+        // ones when the index file is modified.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Constructors and destructors
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        GitIndex(void);
+        // [Abstract]
+        //   Constructor of GitIndex. No index file is read until the first lookup.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        bool list(const Path& dir, const String& prefix, uint32_t n_max_items, bool show_dot, Vector<String>& names) noexcept;
+        // [Abstract]
+        //   Returns names of the tracked entries in the given directory which start with the given
+        //   prefix, in the same order as `list_directory` (directories first). This function is
+        //   thread-safe.
+        //
+        // [Args]
+        //   dir         (const Path&)    : [IN ] Path to the target directory.
+        //   prefix      (const String&)  : [IN ] Prefix of the names to be listed.
+        //   n_max_items (uint32_t)       : [IN ] The maximum number of items to be listed.
+        //   show_dot    (bool)           : [IN ] List dot files even if the prefix does not start with a dot.
+        //   names       (Vector<String>&): [OUT] List of names of the entries.
+        //
+        // [Returns]
+        //   (bool): False if the directory is not in a git work tree or has no tracked file, that
+        //           is, the directory should be listed from the file system.
+
+        Tracked get(const Path& top) noexcept;
+        // [Abstract]
+        //   Returns the tracked paths of the work tree. The index file is parsed again only if it
+        //   is modified since the last lookup. This function is thread-safe.
+        //
+        // [Args]
+        //   top (const Path&): [IN] Top directory of the work tree.
+        //
+        // [Returns]
+        //   (Tracked): Tracked paths (empty if failed to read the index file).
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Static functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        static Path find_top(const Path& dir) noexcept;
+        // [Abstract]
+        //   Returns the top directory of the git work tree which contains the given directory.
+        //
+        // [Args]
+        //   dir (const Path&): [IN] Absolute path to the directory.
+        //
+        // [Returns]
+        //   (Path): Top directory of the work tree (empty if not in a work tree).
+
+        static Tracked parse(const Path& path) noexcept;
+        // [Abstract]
+        //   Parse the index file of the version 2, 3, or 4.
+        //
+        // [Args]
+        //   path (const Path&): [IN] Path to the index file.
+        //
+        // [Returns]
+        //   (Tracked): Tracked paths (null if the index file is broken or not supported).
+
+        static std::string_view path(const Paths& paths, uint32_t index) noexcept;
+        // [Abstract]
+        //   Returns the tracked path of the given index.
+        //
+        // [Args]
+        //   paths (const Paths&): [IN] Tracked paths.
+        //   index (uint32_t)    : [IN] Index of the path in the sorted order.
+        //
+        // [Returns]
+        //   (std::string_view): Tracked path which refers to the arena.
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private data types
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        typedef struct Entry
+        {
+            String  stamp;    // Inode, size, and modification time of the index file.
+            Tracked tracked;  // Tracked paths.
+        }
+        Entry;
+        // Cached paths of a work tree.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member variables
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        Map<String, Entry> repos;
+        // Cached work trees where the key is the top directory.
+
+        std::mutex mutex;
+        // Mutex for the member variables.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        static Path find_index(const Path& top) noexcept;
+        // [Abstract]
+        //   Returns the path to the index file of the work tree, where ".git" may be a file which
+        //   points to the git directory (e.g. linked work trees and submodules).
+};
+
+#endif
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
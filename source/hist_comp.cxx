@@ -5,22 +5,78 @@
 // Include the primary header.
 #include "hist_comp.hxx"
 
+// Include the headers of STL.
+#include <cmath>
+
 // Include the headers of custom modules.
+#include "config.hxx"
 #include "utils.hxx"
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HistCompleter: Constructors
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HistCompleter::HistCompleter(void) : n_hists(0), n_records(0)
+{ /* Do nothing */ }
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // HistCompleter: Member functions
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void HistCompleter::set_hists(const Vector<Pair<StringX, StringX>>& storage) noexcept
+void HistCompleter::append(const StringX& hist) noexcept
 {   // {{{
 
-    // Clear the cache.
-    this->hists.clear();
+    // Empty history never be a completion result.
+    if (hist.size() == 0)
+        return;
 
-    // Update the cache.
-    for (const auto& pair : storage)
-        this->hists.push_back(pair.first + pair.second);
+    // Register the use of the command. The exit status is assumed to be success
+    // until the log record of the command tells it.
+    this->index_all.add(this->register_cmd(hist), this->cmds, this->n_hists, false);
+
+}   // }}}
+
+void HistCompleter::update(const Deque<StringX>& hists, const HistLog* log) noexcept
+{   // {{{
+
+    // Rebuild the index if the number of the histories decreased.
+    if (hists.size() < this->n_hists)
+        *this = HistCompleter();
+
+    // Index only the new histories.
+    for (; this->n_hists < hists.size(); ++this->n_hists)
+        this->append(hists[this->n_hists]);
+
+    // Do nothing if no log is given.
+    if ((log == nullptr) or (log->size() < this->n_records))
+        return;
+
+    // Apply the metadata of the new records.
+    for (; this->n_records < log->size(); ++this->n_records)
+    {
+        const HistLog::Entry& entry  = log->entry(this->n_records);
+        const StringX         hist   = StringX(log->command(this->n_records).c_str());
+        const bool            failed = (entry.exit_code != 0);
+
+        if (hist.size() == 0)
+            continue;
+
+        const uint32_t cmd = this->register_cmd(hist);
+
+        // Update the exit status of the last use.
+        this->index_all.set_failed(cmd, this->cmds, failed);
+
+        // Register the use to the index of the working directory.
+        if (entry.cwd_id != HistLog::CWD_UNKNOWN)
+            this->index_dir[log->directory(entry.cwd_id)].add(cmd, this->cmds, this->n_records, failed);
+    }
+
+}   // }}}
+
+void HistCompleter::set_cwd(const String& cwd) noexcept
+{   // {{{
+
+    this->cwd = cwd;
 
 }   // }}}
 
@@ -31,14 +87,272 @@ StringX HistCompleter::complete(const StringX& lhs) const noexcept
     if (lhs.size() == 0)
         return StringX("");
 
-    // Search the matched history from the end.
-    // If matched string is found, returns the rest of the matched history.
-    for (auto iter = this->hists.rbegin(); iter != this->hists.rend(); ++iter)
-        if (iter->startswith(lhs))
-            return iter->substr(lhs.size()).strip(false, true);
+    // Find the best history from the histories run in the current directory at first,
+    // and find from all histories if not found.
+    uint32_t cmd = Index::NONE;
+
+    const auto iter = this->index_dir.find(this->cwd);
+    if (iter != this->index_dir.end())
+        cmd = iter->second.find(lhs, this->cmds);
+
+    if (cmd == Index::NONE)
+        cmd = this->index_all.find(lhs, this->cmds);
 
     // Returns empty string if no matched history found.
-    return StringX("");
+    if (cmd == Index::NONE)
+        return StringX("");
+
+    // Returns the rest of the best history.
+    return this->cmds[cmd].substr(lhs.size()).strip(false, true);
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HistCompleter: Private member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t HistCompleter::register_cmd(const StringX& hist) noexcept
+{   // {{{
+
+    // Returns the command ID if already registered.
+    const auto iter = this->cmd_ids.find(hist);
+    if (iter != this->cmd_ids.end())
+        return iter->second;
+
+    // Register as a new command.
+    const uint32_t cmd = static_cast<uint32_t>(this->cmds.size());
+    this->cmds.push_back(hist);
+    this->cmd_ids[hist] = cmd;
+
+    return cmd;
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HistCompleter::Index: Constructors
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HistCompleter::Index::Index(void)
+{   // {{{
+
+    // Create the root node.
+    this->nodes.push_back({0, 0, 0, Index::NONE, Index::NONE, -INFINITY, -INFINITY, {}});
+
+    // The cursor points to the root at first.
+    this->cursor = {StringX(""), 0, 0};
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HistCompleter::Index: Member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HistCompleter::Index::add(uint32_t cmd, const Vector<StringX>& cmds, double seq, bool failed) noexcept
+{   // {{{
+
+    // The tree may be changed, therefore the cursor is reset to the root.
+    this->cursor = {StringX(""), 0, 0};
+
+    // Weight of the use in log domain. The weight is doubled for every `histhint_half_life` uses,
+    // which is equivalent to decaying all the other weights.
+    const double weight = seq * std::log(2.0) / config.histhint_half_life;
+
+    // Update the score, where log(exp(a) + exp(b)) is computed in a numerically stable way.
+    auto iter = this->scores.find(cmd);
+    if (iter == this->scores.end())
+    {
+        this->scores[cmd] = {weight, seq, failed};
+    }
+    else
+    {
+        const double a = iter->second.frecency;
+        iter->second.frecency = std::max(a, weight) + std::log1p(std::exp(-std::abs(a - weight)));
+        iter->second.last     = seq;
+        iter->second.failed   = failed;
+    }
+
+    // Update the best commands on the path to the command.
+    this->refresh(this->insert(cmd, cmds));
+
+}   // }}}
+
+void HistCompleter::Index::set_failed(uint32_t cmd, const Vector<StringX>& cmds, bool failed) noexcept
+{   // {{{
+
+    auto iter = this->scores.find(cmd);
+
+    // Do nothing if the status is not changed.
+    if ((iter == this->scores.end()) or (iter->second.failed == failed))
+        return;
+
+    iter->second.failed = failed;
+
+    // Update the best commands on the path to the command.
+    this->refresh(this->insert(cmd, cmds));
+
+}   // }}}
+
+uint32_t HistCompleter::Index::find(const StringX& prefix, const Vector<StringX>& cmds) const noexcept
+{   // {{{
+
+    // Follow the prefix tree from the root along with the query, where `node` is the node whose
+    // edge label is being matched, and `idx` is the position in the edge label.
+    uint32_t node = 0;
+    uint32_t idx  = 0;
+    uint32_t pos  = 0;
+
+    // Resume from the cursor if the query extends the previous query. In this case, only the
+    // appended characters are matched.
+    if (prefix.startswith(this->cursor.prefix))
+    {
+        node = this->cursor.node;
+        idx  = this->cursor.idx;
+        pos  = static_cast<uint32_t>(this->cursor.prefix.size());
+    }
+
+    while ((pos < prefix.size()) and (node != Index::NONE))
+    {
+        // Go down to the child if the whole edge label is matched.
+        if (idx == this->nodes[node].end)
+        {
+            node = this->find_child(node, prefix[pos], cmds);
+            if (node == 0) { node = Index::NONE; break; }
+            idx = this->nodes[node].bgn;
+        }
+
+        // Check the edge label matches with the query.
+        if (cmds[this->nodes[node].cmd][idx].value != prefix[pos].value)
+        {
+            node = Index::NONE;
+            break;
+        }
+
+        ++idx;
+        ++pos;
+    }
+
+    // Save the cursor. Note that the unmatched query is also saved because the query which
+    // extends it never matches.
+    this->cursor = {prefix, node, idx};
+
+    return (node != Index::NONE) ? this->nodes[node].best : Index::NONE;
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HistCompleter::Index: Private member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Pair<double, double> HistCompleter::Index::score(uint32_t cmd) const noexcept
+{   // {{{
+
+    // Returns the lowest score if no command is given.
+    if (cmd == Index::NONE)
+        return {-INFINITY, -INFINITY};
+
+    const Score& score = this->scores.at(cmd);
+
+    // The score of failed command is divided by the penalty.
+    const double penalty = score.failed ? std::log(config.histhint_failure_penalty) : 0.0;
+
+    return {score.frecency - penalty, score.last};
+
+}   // }}}
+
+uint32_t HistCompleter::Index::find_child(uint32_t node, const CharX& cx, const Vector<StringX>& cmds) const noexcept
+{   // {{{
+
+    for (uint32_t child : this->nodes[node].children)
+        if (cmds[this->nodes[child].cmd][this->nodes[child].bgn].value == cx.value)
+            return child;
+
+    return 0;
+
+}   // }}}
+
+Vector<uint32_t> HistCompleter::Index::insert(uint32_t cmd, const Vector<StringX>& cmds) noexcept
+{   // {{{
+
+    // Get the command string.
+    const StringX& str = cmds[cmd];
+
+    // Path from the root to the node of the command.
+    Vector<uint32_t> path = {0};
+
+    // Follow the prefix tree from the root.
+    uint32_t node = 0;
+    uint32_t pos  = 0;
+
+    while (pos < str.size())
+    {
+        const uint32_t child = this->find_child(node, str[pos], cmds);
+
+        // Case 1: no child matched => create a new leaf node.
+        if (child == 0)
+        {
+            this->nodes.push_back({cmd, pos, static_cast<uint32_t>(str.size()), Index::NONE, Index::NONE, -INFINITY, -INFINITY, {}});
+            this->nodes[node].children.push_back(static_cast<uint32_t>(this->nodes.size() - 1));
+            node = static_cast<uint32_t>(this->nodes.size() - 1);
+            path.push_back(node);
+            break;
+        }
+
+        // Compute the length of the common prefix of the edge label and the rest of the command.
+        const StringX& label = cmds[this->nodes[child].cmd];
+        const uint32_t len   = this->nodes[child].end - this->nodes[child].bgn;
+        uint32_t n_common = 0;
+        while ((n_common < len) and (pos + n_common < str.size()) and (label[this->nodes[child].bgn + n_common].value == str[pos + n_common].value))
+            ++n_common;
+
+        // Case 2: a part of the edge label matched => split the edge at the mismatched position.
+        if (n_common < len)
+        {
+            const uint32_t mid = static_cast<uint32_t>(this->nodes.size());
+            const Node&    src = this->nodes[child];
+            this->nodes.push_back({src.cmd, src.bgn, src.bgn + n_common, Index::NONE, src.best, src.best_score, src.best_last, {child}});
+            this->nodes[child].bgn += n_common;
+            std::replace(this->nodes[node].children.begin(), this->nodes[node].children.end(), child, mid);
+            node = mid;
+        }
+
+        // Case 3: whole of the edge label matched => go down to the child.
+        else node = child;
+
+        path.push_back(node);
+        pos += n_common;
+    }
+
+    // Mark the node as the end of the command.
+    this->nodes[node].term = cmd;
+
+    return path;
+
+}   // }}}
+
+void HistCompleter::Index::refresh(const Vector<uint32_t>& path) noexcept
+{   // {{{
+
+    for (auto iter = path.rbegin(); iter != path.rend(); ++iter)
+    {
+        Node& node = this->nodes[*iter];
+
+        // The best command is the best one among the command ending at this node
+        // and the best commands of the child nodes.
+        Pair<double, double> best = this->score(node.term);
+        node.best = node.term;
+
+        for (uint32_t child : node.children)
+        {
+            const Node& c = this->nodes[child];
+            if (Pair<double, double>(c.best_score, c.best_last) > best)
+            {
+                best      = {c.best_score, c.best_last};
+                node.best = c.best;
+            }
+        }
+
+        std::tie(node.best_score, node.best_last) = best;
+    }
 
 }   // }}}
 
@@ -9,6 +9,7 @@
 
 // Include the headers of custom modules.
 #include "dtypes.hxx"
+#include "hist_log.hxx"
 #include "string_x.hxx"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -19,21 +20,48 @@ class HistCompleter
 {
     public:
 
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Constructors and destructors
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        HistCompleter(void);
+        // [Abstract]
+        //   Default constructor of HistCompleter.
+
         ////////////////////////////////////////////////////////////////////////////////////////////
         // Member functions
         ////////////////////////////////////////////////////////////////////////////////////////////
 
-        void set_hists(const Vector<Pair<StringX, StringX>>& storage) noexcept;
+        void append(const StringX& hist) noexcept;
+        // [Abstract]
+        //   Append the given history to the completion index.
+        //
+        // [Args]
+        //   hist (const StringX&): History string to be appended.
+
+        void update(const Deque<StringX>& hists, const HistLog* log = nullptr) noexcept;
         // [Abstract]
-        //   Set the completion cache where the `storage` comes from TextBuffer.
+        //   Update the completion index using the given histories. The histories and the log are
+        //   assumed to be only appended after the last update, therefore only the new histories
+        //   and records are indexed. The index is rebuilt if the number of histories decreased.
+        //   The records of the log are used for the directory-aware ranking and the exit status.
         //
         // [Args]
-        //   storage (const std::vector<std::pair<StringX, StringX>>&): Source of histories.
+        //   hists (const Deque<StringX>&): Source of histories.
+        //   log   (const HistLog*)       : Source of metadata of histories (optional).
+
+        void set_cwd(const String& cwd) noexcept;
+        // [Abstract]
+        //   Set the current working directory. The histories which were run in the directory
+        //   are preferred as completion results.
+        //
+        // [Args]
+        //   cwd (const String&): Current working directory.
 
         StringX complete(const StringX& lhs) const noexcept;
         // [Abstract]
-        //   Returns completion result.
-        //   Note that the `lhs` is not contained in the returned value.
+        //   Returns completion result, that is, the rest of the best history which starts with
+        //   the given string. Note that the `lhs` is not contained in the returned value.
         //
         // [Args]
         //   lhs (const StringX&): Left-hand-side of the editing buffer, i.e. completion query.
@@ -43,12 +71,152 @@ class HistCompleter
 
     private:
 
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Data types
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        class Index
+        {
+            // Ranked prefix index of the commands. This is a compressed prefix tree (radix tree)
+            // where each node holds the best scored command under the node. The score of a command
+            // is a frecency, i.e. sum of exponentially decayed weights of the uses, which is
+            // computed in log domain so that the old scores need not be decayed on each use.
+
+            public:
+
+                static constexpr uint32_t NONE = UINT32_MAX;
+                // Command ID which means "not found".
+
+                Index(void);
+                // [Abstract]
+                //   Default constructor of Index.
+
+                void add(uint32_t cmd, const Vector<StringX>& cmds, double seq, bool failed) noexcept;
+                // [Abstract]
+                //   Register a use of the command.
+                //
+                // [Args]
+                //   cmd    (uint32_t)              : [IN] Command ID.
+                //   cmds   (const Vector<StringX>&): [IN] Command strings.
+                //   seq    (double)                : [IN] Sequence number of the use.
+                //   failed (bool)                  : [IN] True if the command failed.
+
+                void set_failed(uint32_t cmd, const Vector<StringX>& cmds, bool failed) noexcept;
+                // [Abstract]
+                //   Update the exit status of the last use of the command.
+                //
+                // [Args]
+                //   cmd    (uint32_t)              : [IN] Command ID.
+                //   cmds   (const Vector<StringX>&): [IN] Command strings.
+                //   failed (bool)                  : [IN] True if the command failed.
+
+                uint32_t find(const StringX& prefix, const Vector<StringX>& cmds) const noexcept;
+                // [Abstract]
+                //   Find the best scored command which starts with the given prefix. If the prefix
+                //   extends the prefix of the previous call, the search resumes from the node where
+                //   the previous search stopped.
+                //
+                // [Args]
+                //   prefix (const StringX&)        : [IN] Prefix of commands.
+                //   cmds   (const Vector<StringX>&): [IN] Command strings.
+                //
+                // [Returns]
+                //   (uint32_t): Command ID (Index::NONE if not found).
+
+            private:
+
+                typedef struct Node
+                {
+                    uint32_t cmd;               // ID of the command that contains the edge label.
+                    uint32_t bgn, end;          // Edge label is the characters [bgn, end) of the command.
+                    uint32_t term;              // ID of the command which ends at this node.
+                    uint32_t best;              // ID of the best scored command under this node.
+                    double   best_score;        // Score of the best scored command.
+                    double   best_last;         // Sequence number of the last use of the best scored command.
+                    Vector<uint32_t> children;  // Indices of child nodes.
+                }
+                Node;
+                // Node of the compressed prefix tree.
+
+                typedef struct Score
+                {
+                    double frecency;  // Log of the sum of decayed weights.
+                    double last;      // Sequence number of the last use.
+                    bool   failed;    // True if the last use failed.
+                }
+                Score;
+                // Score of a command.
+
+                Vector<Node> nodes;
+                // Nodes of the compressed prefix tree where the first node is the root.
+
+                Map<uint32_t, Score> scores;
+                // Scores of the commands.
+
+                typedef struct Cursor
+                {
+                    StringX  prefix;  // Query of the previous search.
+                    uint32_t node;    // Node where the previous search stopped (NONE if not matched).
+                    uint32_t idx;     // Position in the edge label of the node.
+                }
+                Cursor;
+                // Position of the previous search in the tree.
+
+                mutable Cursor cursor;
+                // Cursor of the previous search which is reset when the tree is modified.
+
+                Pair<double, double> score(uint32_t cmd) const noexcept;
+                // [Abstract]
+                //   Returns a pair of the score in log domain and the sequence number of the last use.
+                //   The pair is compared lexicographically, i.e. the more recent command is better if
+                //   the scores are the same.
+
+                uint32_t find_child(uint32_t node, const CharX& cx, const Vector<StringX>& cmds) const noexcept;
+                // [Abstract]
+                //   Find the child node whose edge label starts with the given character (0 if not found).
+
+                Vector<uint32_t> insert(uint32_t cmd, const Vector<StringX>& cmds) noexcept;
+                // [Abstract]
+                //   Insert the command to the tree if not inserted yet.
+                //   Returns the path (node indices) from the root to the node of the command.
+
+                void refresh(const Vector<uint32_t>& path) noexcept;
+                // [Abstract]
+                //   Recompute the best command of the nodes on the path from the bottom.
+        };
+
         ////////////////////////////////////////////////////////////////////////////////////////////
         // Private member variables
         ////////////////////////////////////////////////////////////////////////////////////////////
 
-        Vector<StringX> hists;
-        // A list of histories.
+        Vector<StringX> cmds;
+        // Distinct command strings where the index is the command ID.
+
+        Map<StringX, uint32_t> cmd_ids;
+        // Reverse lookup table of the command strings.
+
+        Index index_all;
+        // Ranked prefix index of all histories.
+
+        Map<String, Index> index_dir;
+        // Ranked prefix index of histories for each working directory.
+
+        String cwd;
+        // Current working directory.
+
+        uint32_t n_hists;
+        // Number of the source histories already indexed by `update`.
+
+        uint32_t n_records;
+        // Number of the log records already indexed by `update`.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        uint32_t register_cmd(const StringX& hist) noexcept;
+        // [Abstract]
+        //   Register the command string if not registered yet and returns the command ID.
 };
 
 #endif
@@ -0,0 +1,358 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ source file: hist_index.cxx                                                              ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Include the primary header.
+#include "hist_index.hxx"
+
+// Include the headers of STL.
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <queue>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Static functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static Vector<uint32_t> build_suffix_array(const String& text) noexcept
+// [Abstract]
+//   Build the suffix array of the given text by prefix doubling with radix sort.
+//
+// [Args]
+//   text (const String&): Target text.
+//
+// [Returns]
+//   (Vector<uint32_t>): Suffix array.
+//
+{   // {{{
+
+    const uint32_t n = static_cast<uint32_t>(text.size());
+
+    Vector<uint32_t> sa(n), rank(n), tmp(n), count(std::max<uint32_t>(n, 0x10000) + 1);
+
+    if (n == 0)
+        return sa;
+
+    // Pack the first 4 bytes of each suffix into an integer key so that the first two rounds of
+    // the prefix doubling are skipped.
+    Vector<uint32_t> keys(n);
+    for (uint32_t i = 0; i < n; ++i)
+        for (uint32_t j = 0; j < 4; ++j)
+            keys[i] = (keys[i] << 8) | ((i + j < n) ? static_cast<uint8_t>(text[i + j]) : 0);
+
+    // Sort the suffixes by the key using LSD radix sort (lower 16 bits, then upper 16 bits).
+    for (uint32_t i = 0; i < n; ++i) tmp[i] = i;
+    for (uint32_t shift : {0u, 16u})
+    {
+        std::fill(count.begin(), count.begin() + 0x10001, 0);
+        for (uint32_t i = 0; i < n; ++i) ++count[((keys[tmp[i]] >> shift) & 0xFFFF) + 1];
+        for (uint32_t c = 1; c <= 0x10000; ++c) count[c] += count[c - 1];
+        for (uint32_t i = 0; i < n; ++i) sa[count[(keys[tmp[i]] >> shift) & 0xFFFF]++] = tmp[i];
+        if (shift == 0) sa.swap(tmp);
+    }
+
+    // Compute the initial ranks. Note that the zero padding of the keys makes the ranks of
+    // the suffixes shorter than 4 bytes ambiguous only if the text contains null characters,
+    // which never appear in histories.
+    rank[sa[0]] = 0;
+    for (uint32_t i = 1; i < n; ++i)
+        rank[sa[i]] = rank[sa[i - 1]] + ((keys[sa[i]] != keys[sa[i - 1]]) ? 1 : 0);
+
+    for (uint32_t k = 4; (rank[sa[n - 1]] < n - 1) and (k < n); k <<= 1)
+    {
+        // Order the suffixes by the second key (rank of the suffix at i + k). The suffixes which
+        // have no second key come first.
+        uint32_t m = 0;
+        for (uint32_t i = n - k; i < n; ++i) tmp[m++] = i;
+        for (uint32_t i = 0;     i < n; ++i) if (sa[i] >= k) tmp[m++] = sa[i] - k;
+
+        // Stable counting sort by the first key.
+        const uint32_t n_ranks = rank[sa[n - 1]] + 1;
+        std::fill(count.begin(), count.begin() + n_ranks + 1, 0);
+        for (uint32_t i = 0; i < n; ++i) ++count[rank[i] + 1];
+        for (uint32_t r = 1; r <= n_ranks; ++r) count[r] += count[r - 1];
+        for (uint32_t i = 0; i < n; ++i) sa[count[rank[tmp[i]]]++] = tmp[i];
+
+        // Compute the new ranks.
+        const auto second = [&rank, n, k](uint32_t i) noexcept -> int64_t
+        { return (i + k < n) ? static_cast<int64_t>(rank[i + k]) : -1; };
+
+        tmp[sa[0]] = 0;
+        for (uint32_t i = 1; i < n; ++i)
+        {
+            const bool same = (rank[sa[i]] == rank[sa[i - 1]]) and (second(sa[i]) == second(sa[i - 1]));
+            tmp[sa[i]] = tmp[sa[i - 1]] + (same ? 0 : 1);
+        }
+        rank.swap(tmp);
+    }
+
+    return sa;
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HistIndex: Constructors
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HistIndex::HistIndex(void)
+{ /* Do nothing */ }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HistIndex: Member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HistIndex::update(const Deque<StringX>& hists) noexcept
+{   // {{{
+
+    // Clear everything if the histories are truncated.
+    if (hists.size() < this->starts.size())
+    {
+        if (this->building.valid()) this->building.wait();
+        this->building = {};
+        this->built.reset();
+        this->text.clear();
+        this->starts.clear();
+    }
+
+    // Append the new histories to the text.
+    for (size_t index = this->starts.size(); index < hists.size(); ++index)
+    {
+        this->starts.push_back(static_cast<uint32_t>(this->text.size()));
+        this->text += hists[index].string();
+        this->text += '\n';
+    }
+
+    // Replace the suffix array if the background rebuild completed.
+    this->poll();
+
+    // Start a background rebuild if the unindexed tail is large.
+    const size_t n_bytes = (this->built != nullptr) ? this->built->n_bytes : 0;
+    if ((not this->building.valid()) and (this->text.size() - n_bytes > HistIndex::TAIL_MAX_BYTES))
+        this->building = std::async(std::launch::async, HistIndex::build, this->text, this->starts);
+
+}   // }}}
+
+void HistIndex::compact(bool wait) noexcept
+{   // {{{
+
+    // Replace the suffix array if the background rebuild completed.
+    this->poll();
+
+    // Start a background rebuild unless running. The rebuild which does not cover all histories
+    // (i.e. started before the last update) is followed by another one if waiting.
+    while (this->size_indexed() < this->starts.size())
+    {
+        if (not this->building.valid())
+            this->building = std::async(std::launch::async, HistIndex::build, this->text, this->starts);
+
+        if (not wait)
+            break;
+
+        this->built = this->building.get();
+    }
+
+}   // }}}
+
+Vector<uint32_t> HistIndex::find(const String& query, uint16_t max_results) noexcept
+{   // {{{
+
+    Vector<uint32_t> results;
+    Set<String>      found;
+
+    // Replace the suffix array if the background rebuild completed.
+    this->poll();
+
+    if ((query.size() == 0) or (max_results == 0))
+        return results;
+
+    // Register the history to the results if the same string is not registered yet.
+    const auto report = [this, &results, &found](uint32_t index) noexcept
+    {
+        if (found.insert(this->get(index)).second)
+            results.push_back(index);
+    };
+
+    // Step 1: scan the unindexed tail linearly from the most recent history.
+    const size_t n_hists = (this->built != nullptr) ? this->built->n_hists : 0;
+    for (size_t index = this->starts.size(); (index > n_hists) and (results.size() < max_results); --index)
+    {
+        const size_t bgn = this->starts[index - 1];
+        const size_t end = (index < this->starts.size()) ? this->starts[index] : this->text.size();
+        const void*  pos = memmem(this->text.data() + bgn, end - bgn - 1, query.data(), query.size());
+
+        if (pos != nullptr)
+            report(static_cast<uint32_t>(index - 1));
+    }
+
+    if ((this->built == nullptr) or (results.size() >= max_results))
+        return results;
+
+    // Step 2: find the range of suffixes which start with the query by binary search.
+    const Built&   idx = *this->built;
+    const uint32_t n   = static_cast<uint32_t>(idx.n_bytes);
+
+    const auto less_suffix = [this, n](uint32_t pos, const String& str) noexcept -> bool
+    { return std::memcmp(this->text.data() + pos, str.data(), std::min<size_t>(n - pos, str.size())) < 0 or
+             ((n - pos < str.size()) and std::memcmp(this->text.data() + pos, str.data(), n - pos) == 0); };
+
+    const auto less_prefix = [this, n](const String& str, uint32_t pos) noexcept -> bool
+    { return std::memcmp(this->text.data() + pos, str.data(), std::min<size_t>(n - pos, str.size())) > 0; };
+
+    const auto iter_bgn = std::lower_bound(idx.sa.begin(), idx.sa.end(), query, less_suffix);
+    const auto iter_end = std::upper_bound(iter_bgn,       idx.sa.end(), query, less_prefix);
+
+    if (iter_bgn == iter_end)
+        return results;
+
+    // Step 3: report the histories in descending order of the history index. The range is split
+    // at the position of the maximum, and the sub-ranges are processed by a priority queue.
+    typedef Tuple<uint32_t, uint32_t, uint32_t, uint32_t> Range;  // (ID, position, begin, end)
+
+    std::priority_queue<Range> queue;
+
+    const auto push = [this, &idx, &queue](uint32_t bgn, uint32_t end) noexcept
+    {
+        if (bgn >= end) return;
+        const uint32_t pos = this->argmax(idx, bgn, end);
+        queue.emplace(idx.ids[pos], pos, bgn, end);
+    };
+
+    push(static_cast<uint32_t>(iter_bgn - idx.sa.begin()), static_cast<uint32_t>(iter_end - idx.sa.begin()));
+
+    while ((not queue.empty()) and (results.size() < max_results))
+    {
+        const auto [id, pos, bgn, end] = queue.top();
+        queue.pop();
+
+        // Note that the same history appears multiple times if it contains the query several
+        // times, but it is reported only once.
+        report(id);
+
+        push(bgn, pos);
+        push(pos + 1, end);
+    }
+
+    return results;
+
+}   // }}}
+
+String HistIndex::get(uint32_t index) const noexcept
+{   // {{{
+
+    const size_t bgn = this->starts[index];
+    const size_t end = (index + 1 < this->starts.size()) ? this->starts[index + 1] : this->text.size();
+
+    return this->text.substr(bgn, end - bgn - 1);
+
+}   // }}}
+
+size_t HistIndex::size_indexed(void) const noexcept
+{   // {{{
+
+    return (this->built != nullptr) ? this->built->n_hists : 0;
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HistIndex: Private member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HistIndex::poll(void) noexcept
+{   // {{{
+
+    using namespace std::chrono_literals;
+
+    if (this->building.valid() and (this->building.wait_for(0s) == std::future_status::ready))
+        this->built = this->building.get();
+
+}   // }}}
+
+uint32_t HistIndex::argmax(const Built& idx, uint32_t bgn, uint32_t end) const noexcept
+{   // {{{
+
+    const auto better = [&idx](uint32_t a, uint32_t b) noexcept -> uint32_t
+    { return (idx.ids[a] >= idx.ids[b]) ? a : b; };
+
+    uint32_t best = bgn;
+
+    // Scan the partial blocks at both ends.
+    const uint32_t block_bgn = (bgn + HistIndex::BLOCK - 1) / HistIndex::BLOCK;
+    const uint32_t block_end = end / HistIndex::BLOCK;
+
+    if (block_bgn >= block_end)
+    {
+        for (uint32_t pos = bgn; pos < end; ++pos) best = better(best, pos);
+        return best;
+    }
+
+    for (uint32_t pos = bgn; pos < block_bgn * HistIndex::BLOCK; ++pos) best = better(best, pos);
+    for (uint32_t pos = block_end * HistIndex::BLOCK; pos < end; ++pos) best = better(best, pos);
+
+    // Look up the sparse table for the whole blocks.
+    const uint32_t level = std::bit_width(block_end - block_bgn) - 1;
+    best = better(best, idx.rmq[level][block_bgn]);
+    best = better(best, idx.rmq[level][block_end - (1u << level)]);
+
+    return best;
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HistIndex: Static member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<const HistIndex::Built> HistIndex::build(String text, Vector<uint32_t> starts) noexcept
+{   // {{{
+
+    auto idx = std::make_shared<Built>();
+
+    idx->n_bytes = text.size();
+    idx->n_hists = starts.size();
+    idx->sa      = build_suffix_array(text);
+
+    // Compute the history index of each byte, and then of each suffix.
+    Vector<uint32_t> owners(text.size());
+    for (size_t index = 0; index < starts.size(); ++index)
+    {
+        const size_t end = (index + 1 < starts.size()) ? starts[index + 1] : text.size();
+        std::fill(owners.begin() + starts[index], owners.begin() + end, static_cast<uint32_t>(index));
+    }
+
+    idx->ids.resize(idx->sa.size());
+    for (size_t i = 0; i < idx->sa.size(); ++i)
+        idx->ids[i] = owners[idx->sa[i]];
+
+    // Build the sparse table where rmq[j][b] is the position of the maximum ID in the blocks
+    // [b, b + 2^j).
+    const size_t n_blocks = idx->sa.size() / HistIndex::BLOCK;
+    if (n_blocks > 0)
+    {
+        idx->rmq.emplace_back(n_blocks);
+        for (size_t b = 0; b < n_blocks; ++b)
+        {
+            const auto bgn = idx->ids.begin() + b * HistIndex::BLOCK;
+            idx->rmq[0][b] = static_cast<uint32_t>(std::max_element(bgn, bgn + HistIndex::BLOCK) - idx->ids.begin());
+        }
+
+        for (size_t j = 1; (size_t(1) << j) <= n_blocks; ++j)
+        {
+            const Vector<uint32_t>& prev = idx->rmq[j - 1];
+            Vector<uint32_t> curr(n_blocks - (size_t(1) << j) + 1);
+
+            for (size_t b = 0; b < curr.size(); ++b)
+            {
+                const uint32_t x = prev[b], y = prev[b + (size_t(1) << (j - 1))];
+                curr[b] = (idx->ids[x] >= idx->ids[y]) ? x : y;
+            }
+
+            idx->rmq.push_back(std::move(curr));
+        }
+    }
+
+    return idx;
+
+}   // }}}
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
@@ -0,0 +1,165 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ header file: hist_index.hxx                                                              ///
+///                                                                                              ///
+/// This file defines the class `HistIndex` which provides the substring search of histories.    ///
+/// A suffix array is built over the concatenated history text, and the most recent histories    ///
+/// which contain the query are reported by range-maximum queries over the history IDs. The      ///
+/// histories appended after the last build are scanned linearly, and the suffix array is        ///
+/// rebuilt on a background thread when the histories are loaded or the tail becomes large.      ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef HIST_INDEX_HXX
+#define HIST_INDEX_HXX
+
+// Include the headers of STL.
+#include <cstdint>
+#include <future>
+#include <memory>
+
+// Include the headers of custom modules.
+#include "dtypes.hxx"
+#include "string_x.hxx"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Class definitions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class HistIndex
+{
+    public:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Constructors and destructors
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        HistIndex(void);
+        // [Abstract]
+        //   Default constructor of HistIndex.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        void update(const Deque<StringX>& hists) noexcept;
+        // [Abstract]
+        //   Update the search target using the given histories. The histories are assumed to be
+        //   only appended after the last update, therefore only the new histories are added to
+        //   the unindexed tail. A background rebuild is started if the tail becomes large.
+        //   Everything is cleared if the number of histories decreased.
+        //
+        // [Args]
+        //   hists (const Deque<StringX>&): Source of histories.
+
+        void compact(bool wait = false) noexcept;
+        // [Abstract]
+        //   Rebuild the suffix array over all histories on a background thread if some histories
+        //   are not indexed, e.g. when the histories are loaded. The rebuild is started after the
+        //   running one finishes, and the new suffix array is used from the next update.
+        //
+        // [Args]
+        //   wait (bool): Wait for the rebuild and use it immediately if true.
+
+        Vector<uint32_t> find(const String& query, uint16_t max_results) noexcept;
+        // [Abstract]
+        //   Find the most recent histories which contain the query as a substring.
+        //   Histories with the same string are reported only once.
+        //
+        // [Args]
+        //   query       (const String&): Search query.
+        //   max_results (uint16_t)     : Maximum number of results.
+        //
+        // [Returns]
+        //   (Vector<uint32_t>): Indices of the histories from the most recent one.
+
+        String get(uint32_t index) const noexcept;
+        // [Abstract]
+        //   Returns the history string of the given index.
+        //
+        // [Args]
+        //   index (uint32_t): History index returned by `find`.
+        //
+        // [Returns]
+        //   (String): History string.
+
+        size_t size_indexed(void) const noexcept;
+        // [Abstract]
+        //   Returns the number of histories covered by the suffix array.
+        //
+        // [Returns]
+        //   (size_t): Number of indexed histories.
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Data types
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        typedef struct Built
+        {
+            size_t n_bytes;                // Byte size of the indexed text.
+            size_t n_hists;                // Number of the indexed histories.
+            Vector<uint32_t> sa;           // Suffix array of the indexed text.
+            Vector<uint32_t> ids;          // History index of each suffix.
+            Vector<Vector<uint32_t>> rmq;  // Sparse table of the position of maximum ID in blocks.
+        }
+        Built;
+        // Suffix array and its auxiliary tables.
+
+        static constexpr uint32_t BLOCK = 32;
+        // Block size of the range-maximum query.
+
+        static constexpr size_t TAIL_MAX_BYTES = 1 << 20;
+        // Maximum byte size of the unindexed tail before starting a background rebuild.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member variables
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        String text;
+        // Concatenated history strings where each history is terminated by a newline.
+
+        Vector<uint32_t> starts;
+        // Byte offset of each history in the text.
+
+        std::shared_ptr<const Built> built;
+        // Current suffix array (null if not built yet).
+
+        std::future<std::shared_ptr<const Built>> building;
+        // Suffix array which is being built on the background thread.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        void poll(void) noexcept;
+        // [Abstract]
+        //   Replace the current suffix array if the background rebuild completed.
+
+        uint32_t argmax(const Built& idx, uint32_t bgn, uint32_t end) const noexcept;
+        // [Abstract]
+        //   Returns the position of the maximum history index in the range [bgn, end).
+        //
+        // [Args]
+        //   idx (const Built&): Suffix array.
+        //   bgn (uint32_t)    : Beginning of the range (inclusive).
+        //   end (uint32_t)    : End of the range (exclusive).
+        //
+        // [Returns]
+        //   (uint32_t): Position in the suffix array.
+
+        static std::shared_ptr<const Built> build(String text, Vector<uint32_t> starts) noexcept;
+        // [Abstract]
+        //   Build a suffix array and its auxiliary tables. This function can be called from the
+        //   background thread because it takes copies of the text and offsets.
+        //
+        // [Args]
+        //   text   (String)          : Concatenated history strings.
+        //   starts (Vector<uint32_t>): Byte offset of each history in the text.
+        //
+        // [Returns]
+        //   (std::shared_ptr<const Built>): Built suffix array.
+};
+
+#endif
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
@@ -0,0 +1,505 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ source file: hist_log.cxx                                                                ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Include the primary header.
+#include "hist_log.hxx"
+
+// Include the headers of STL.
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Include the headers of custom modules.
+#include "utils.hxx"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Static functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static bool append_binary(const Path& path, const char* data, size_t size) noexcept
+// [Abstract]
+//   Append binary data to a file.
+//
+// [Args]
+//   path (const Path&) : [IN] Path to target file.
+//   data (const char*) : [IN] Pointer to the data to be written.
+//   size (size_t)      : [IN] Byte size of the data.
+//
+// [Returns]
+//   (bool): True if succeeded.
+//
+{   // {{{
+
+    // Open the file with append mode.
+    FILE *ofp = fopen(path.c_str(), "ab");
+    if (ofp == NULL)
+        return false;
+
+    // Write the given data.
+    const bool succeeded = (fwrite(data, 1, size, ofp) == size);
+    fflush(ofp);
+
+    // Close the file.
+    fclose(ofp);
+
+    return succeeded;
+
+}   // }}}
+
+static String read_binary(const Path& path) noexcept
+// [Abstract]
+//   Read whole contents of a file as a binary string.
+//
+// [Args]
+//   path (const Path&): [IN] Path to target file.
+//
+// [Returns]
+//   (String): Contents of the file (empty if failed to read).
+//
+{   // {{{
+
+    String buffer;
+
+    // Open the file with read mode.
+    FILE *ifp = fopen(path.c_str(), "rb");
+    if (ifp == NULL)
+        return buffer;
+
+    // Get the file size.
+    fseek(ifp, 0, SEEK_END);
+    const long size = ftell(ifp);
+    fseek(ifp, 0, SEEK_SET);
+
+    // Read the whole file at once.
+    if (size > 0)
+    {
+        buffer.resize(static_cast<size_t>(size));
+        buffer.resize(fread(buffer.data(), 1, buffer.size(), ifp));
+    }
+
+    // Close the file.
+    fclose(ifp);
+
+    return buffer;
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HistLog: Constructors
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HistLog::HistLog(const Path& path, HistWriter* writer) : writer(writer), size_log(0), bulk(false)
+{   // {{{
+
+    this->path_log = path;
+    this->path_idx = Path(path.string() + ".idx");
+    this->path_dir = Path(path.string() + ".dirs");
+
+    // Create directory if not exists.
+    if (this->path_log.has_parent_path() and (not std::filesystem::exists(this->path_log.parent_path())))
+        std::filesystem::create_directories(this->path_log.parent_path());
+
+    // Load file contents.
+    this->load();
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HistLog: Member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HistLog::append(const String& command, const String& cwd, int64_t time, int32_t exit_code, uint32_t duration) noexcept
+{   // {{{
+
+    // Get the ID of the working directory.
+    const uint32_t cwd_id = this->register_dir(cwd);
+
+    // Create the record header.
+    const Header header = {HistLog::MAGIC, static_cast<uint32_t>(command.size()), time, cwd_id, exit_code, duration, 0};
+
+    // Create the record (header + command string) and write it at once.
+    String record(reinterpret_cast<const char*>(&header), sizeof(Header));
+    record += command;
+    this->write(this->path_log, record);
+
+    // The index file is not written here because the offset of the record is not known until
+    // the writer appends it after the records of other sessions. The record is indexed from the
+    // log file at the next load.
+    const Entry entry = {this->size_log, time, cwd_id, exit_code, duration, header.length};
+    this->size_log += record.size();
+
+    // Update in-memory lookup tables.
+    this->register_entry(entry, command);
+
+}   // }}}
+
+uint32_t HistLog::import_text(const Path& path) noexcept
+{   // {{{
+
+    // Lock the log file while importing, and import only if the log is still empty, so that the
+    // sessions started at the same time do not import the same history twice.
+    const int fd = open(this->path_log.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return 0;
+
+    flock(fd, LOCK_EX);
+
+    struct stat st;
+    if ((fstat(fd, &st) != 0) or (st.st_size > 0) or (this->size_log > 0))
+    {
+        flock(fd, LOCK_UN);
+        close(fd);
+        return 0;
+    }
+
+    uint32_t count = 0;
+    String   log, idx;
+
+    this->bulk = true;
+
+    for (const String& line : read_lines(path.string()))
+    {
+        // Skip empty lines.
+        if (line.size() == 0)
+            continue;
+
+        const Header header = {HistLog::MAGIC, static_cast<uint32_t>(line.size()), 0, HistLog::CWD_UNKNOWN, 0, 0, 0};
+        const Entry  entry  = {this->size_log, 0, HistLog::CWD_UNKNOWN, 0, 0, header.length};
+
+        log.append(reinterpret_cast<const char*>(&header), sizeof(Header));
+        log += line;
+        idx.append(reinterpret_cast<const char*>(&entry), sizeof(Entry));
+
+        this->size_log += sizeof(Header) + line.size();
+        this->register_entry(entry, line);
+        ++count;
+    }
+
+    // The records are written synchronously while locked, and indexed at once because their
+    // offsets are fixed by the lock.
+    append_binary(this->path_log, log.data(), log.size());
+    append_binary(this->path_idx, idx.data(), idx.size());
+
+    flock(fd, LOCK_UN);
+    close(fd);
+
+    this->sort_by_prefix();
+    this->bulk = false;
+
+    return count;
+
+}   // }}}
+
+size_t HistLog::size(void) const noexcept
+{   // {{{
+
+    return this->entries.size();
+
+}   // }}}
+
+const HistLog::Entry& HistLog::entry(uint32_t index) const noexcept
+{   // {{{
+
+    return this->entries[index];
+
+}   // }}}
+
+const String& HistLog::command(uint32_t index) const noexcept
+{   // {{{
+
+    return this->commands[index];
+
+}   // }}}
+
+const String& HistLog::directory(uint32_t cwd_id) const noexcept
+{   // {{{
+
+    // Returned value if the directory is unknown.
+    static const String unknown;
+
+    const auto iter = this->dirs.find(cwd_id);
+
+    return (iter != this->dirs.end()) ? iter->second : unknown;
+
+}   // }}}
+
+uint32_t HistLog::directory_id(const String& cwd) const noexcept
+{   // {{{
+
+    if (cwd.size() == 0)
+        return HistLog::CWD_UNKNOWN;
+
+    const uint32_t cwd_id = this->probe_dir(cwd);
+
+    return this->dirs.contains(cwd_id) ? cwd_id : HistLog::CWD_UNKNOWN;
+
+}   // }}}
+
+Pair<uint32_t, uint32_t> HistLog::find_by_time(int64_t time_bgn, int64_t time_end) const noexcept
+{   // {{{
+
+    constexpr auto less_time = [](const Entry& entry, int64_t time) noexcept -> bool { return entry.time < time; };
+
+    // Find the beginning and end of the range by binary search.
+    const auto iter_bgn = std::lower_bound(this->entries.begin(), this->entries.end(), time_bgn, less_time);
+    const auto iter_end = std::lower_bound(iter_bgn,              this->entries.end(), time_end, less_time);
+
+    return {static_cast<uint32_t>(iter_bgn - this->entries.begin()), static_cast<uint32_t>(iter_end - this->entries.begin())};
+
+}   // }}}
+
+const Vector<uint32_t>& HistLog::find_by_dir(const String& cwd) const noexcept
+{   // {{{
+
+    // Returned value if no record found.
+    static const Vector<uint32_t> empty;
+
+    // Find the directory ID.
+    const uint32_t cwd_id = this->directory_id(cwd);
+    if (cwd_id == HistLog::CWD_UNKNOWN)
+        return empty;
+
+    // Find the records of the directory.
+    const auto iter = this->by_dir.find(cwd_id);
+
+    return (iter != this->by_dir.end()) ? iter->second : empty;
+
+}   // }}}
+
+Vector<uint32_t> HistLog::find_by_prefix(const String& prefix) const noexcept
+{   // {{{
+
+    const auto less_command = [this](uint32_t index, const String& str) noexcept -> bool
+    { return this->commands[index] < str; };
+
+    Vector<uint32_t> result;
+
+    // Find the first command which is not less than the prefix.
+    // All commands that start with the prefix are placed contiguously after it.
+    auto iter = std::lower_bound(this->by_prefix.begin(), this->by_prefix.end(), prefix, less_command);
+
+    for (; (iter != this->by_prefix.end()) and this->commands[*iter].starts_with(prefix); ++iter)
+        result.push_back(*iter);
+
+    // Sort the result in chronological order.
+    std::sort(result.begin(), result.end());
+
+    return result;
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HistLog: Private member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HistLog::load(void) noexcept
+{   // {{{
+
+    this->load_dirs();
+
+    // Lock the log file while loading, so that other sessions neither append records nor extend
+    // the index file until the index covers all records of the log.
+    const int fd = open(this->path_log.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd >= 0)
+        flock(fd, LOCK_EX);
+
+    // Read the log file and the index file.
+    const String log = read_binary(this->path_log);
+    const String idx = read_binary(this->path_idx);
+
+    this->bulk = true;
+
+    // Load the records listed in the index file.
+    // The index entries which point outside of the log file are dropped.
+    uint64_t offset = 0;
+    for (size_t pos = 0; (pos + sizeof(Entry)) <= idx.size(); pos += sizeof(Entry))
+    {
+        Entry entry;
+        std::copy_n(idx.data() + pos, sizeof(Entry), reinterpret_cast<char*>(&entry));
+
+        if ((entry.offset != offset) or ((entry.offset + sizeof(Header) + entry.length) > log.size()))
+            break;
+
+        this->register_entry(entry, log.substr(entry.offset + sizeof(Header), entry.length));
+        offset = entry.offset + sizeof(Header) + entry.length;
+    }
+
+    // Drop the broken entries of the index file.
+    if (idx.size() != this->entries.size() * sizeof(Entry))
+    {
+        std::error_code ec;
+        std::filesystem::resize_file(this->path_idx, this->entries.size() * sizeof(Entry), ec);
+    }
+
+    // Index the records which are not covered by the index, for example, the records appended
+    // after the last load, or when the process was killed before loading them.
+    String idx_new;
+    while ((offset + sizeof(Header)) <= log.size())
+    {
+        Header header;
+        std::copy_n(log.data() + offset, sizeof(Header), reinterpret_cast<char*>(&header));
+
+        if ((header.magic != HistLog::MAGIC) or ((offset + sizeof(Header) + header.length) > log.size()))
+            break;
+
+        const Entry entry = {offset, header.time, header.cwd_id, header.exit_code, header.duration, header.length};
+        idx_new.append(reinterpret_cast<const char*>(&entry), sizeof(Entry));
+
+        this->register_entry(entry, log.substr(offset + sizeof(Header), header.length));
+        offset += sizeof(Header) + header.length;
+    }
+
+    if (idx_new.size() > 0)
+        append_binary(this->path_idx, idx_new.data(), idx_new.size());
+
+    // Truncate the broken tail of the log file so that the next record is placed properly.
+    // No record is being written here because the writers also lock the log file.
+    if (offset < log.size())
+        std::filesystem::resize_file(this->path_log, offset);
+
+    // The next record will be placed at the end of the valid records.
+    this->size_log = offset;
+
+    if (fd >= 0)
+    {
+        flock(fd, LOCK_UN);
+        close(fd);
+    }
+
+    this->sort_by_prefix();
+    this->bulk = false;
+
+}   // }}}
+
+void HistLog::write(const Path& path, const String& data) noexcept
+{   // {{{
+
+    if (this->writer != nullptr) this->writer->write(path, data);
+    else                         append_binary(path, data.data(), data.size());
+
+}   // }}}
+
+void HistLog::load_dirs(void) noexcept
+{   // {{{
+
+    if (not std::filesystem::exists(this->path_dir))
+        return;
+
+    // The IDs are assigned in the order of the file, which is the same for all sessions.
+    for (const String& line : read_lines(this->path_dir.string()))
+    {
+        if (line.size() == 0)
+            continue;
+
+        const uint32_t cwd_id = this->probe_dir(line);
+        if (not this->dirs.contains(cwd_id))
+            this->dirs.emplace(cwd_id, line);
+    }
+
+}   // }}}
+
+uint32_t HistLog::hash_dir(const String& cwd) noexcept
+{   // {{{
+
+    // FNV-1a hash of 32 bits.
+    uint32_t hash_value = 0x811C9DC5;
+    for (const char c : cwd)
+        hash_value = (hash_value ^ static_cast<uint8_t>(c)) * 0x01000193;
+
+    // The ID 0 is reserved for unknown directories.
+    return (hash_value == HistLog::CWD_UNKNOWN) ? 1 : hash_value;
+
+}   // }}}
+
+uint32_t HistLog::probe_dir(const String& cwd) const noexcept
+{   // {{{
+
+    uint32_t cwd_id = HistLog::hash_dir(cwd);
+
+    // Skip the IDs used by the other directories, where the ID 0 is reserved.
+    for (auto iter = this->dirs.find(cwd_id); (iter != this->dirs.end()) and (iter->second != cwd); iter = this->dirs.find(cwd_id))
+        cwd_id = (cwd_id == UINT32_MAX) ? 1 : (cwd_id + 1);
+
+    return cwd_id;
+
+}   // }}}
+
+uint32_t HistLog::register_dir(const String& cwd) noexcept
+{   // {{{
+
+    // Empty string means unknown directory.
+    if (cwd.size() == 0)
+        return HistLog::CWD_UNKNOWN;
+
+    // Returns the ID if already registered.
+    uint32_t cwd_id = this->probe_dir(cwd);
+    if (this->dirs.contains(cwd_id))
+        return cwd_id;
+
+    // Lock the directory table file, and read the directories registered by other sessions, so
+    // that the ID is assigned in the same order as the file. The directory is appended while
+    // locked, therefore it is written synchronously.
+    const int fd = open(this->path_dir.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (fd >= 0)
+        flock(fd, LOCK_EX);
+
+    this->load_dirs();
+
+    cwd_id = this->probe_dir(cwd);
+    if ((not this->dirs.contains(cwd_id)) and (fd >= 0))
+    {
+        const String line = cwd + '\n';
+        if (::write(fd, line.data(), line.size()) == static_cast<ssize_t>(line.size()))
+            this->dirs.emplace(cwd_id, cwd);
+    }
+
+    if (fd >= 0)
+    {
+        flock(fd, LOCK_UN);
+        close(fd);
+    }
+
+    // The directory is unknown if it cannot be written to the file.
+    return this->dirs.contains(cwd_id) ? cwd_id : HistLog::CWD_UNKNOWN;
+
+}   // }}}
+
+void HistLog::register_entry(const Entry& entry, const String& command) noexcept
+{   // {{{
+
+    const auto less_command = [this](const String& str, uint32_t index) noexcept -> bool
+    { return str < this->commands[index]; };
+
+    const uint32_t index = static_cast<uint32_t>(this->entries.size());
+
+    // Register the record.
+    this->entries.push_back(entry);
+    this->commands.push_back(command);
+
+    // Register to the lookup table of working directories.
+    this->by_dir[entry.cwd_id].push_back(index);
+
+    // Register to the lookup table of prefixes. The new index is inserted after the same commands
+    // so that the indices of the same command are kept in chronological order. The records
+    // registered in bulk are sorted at once by `sort_by_prefix`.
+    if (this->bulk)
+        this->by_prefix.push_back(index);
+    else
+        this->by_prefix.insert(std::upper_bound(this->by_prefix.begin(), this->by_prefix.end(), command, less_command), index);
+
+}   // }}}
+
+void HistLog::sort_by_prefix(void) noexcept
+{   // {{{
+
+    // The stable sort keeps the indices of the same command in chronological order.
+    std::stable_sort(this->by_prefix.begin(), this->by_prefix.end(), [this](uint32_t a, uint32_t b) noexcept
+    { return this->commands[a] < this->commands[b]; });
+
+}   // }}}
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
@@ -0,0 +1,292 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ header file: hist_log.hxx                                                                ///
+///                                                                                              ///
+/// This file defines the class `HistLog` which manages the binary history log. Each record of   ///
+/// the log has a fixed-size header (time, working directory ID, exit code, and duration) that   ///
+/// is followed by the command string, and a sidecar index file makes it possible to look up the ///
+/// records without parsing the whole log. The log may be shared by multiple sessions, so the    ///
+/// index is extended only while loading under the lock of the log, and the working directories  ///
+/// are identified by the hash of their paths (probed to the next free ID on collision) instead  ///
+/// of session-local serial numbers.                                                             ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef HIST_LOG_HXX
+#define HIST_LOG_HXX
+
+// Include the headers of STL.
+#include <cstdint>
+
+// Include the headers of custom modules.
+#include "dtypes.hxx"
+#include "hist_writer.hxx"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Class definitions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class HistLog
+{
+    public:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Data types
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        typedef struct Header
+        {
+            uint32_t magic;      // Record marker (HistLog::MAGIC).
+            uint32_t length;     // Byte size of the command string.
+            int64_t  time;       // Unix time when the command was started.
+            uint32_t cwd_id;     // ID of the working directory (hash of the path).
+            int32_t  exit_code;  // Exit code of the command.
+            uint32_t duration;   // Duration of the command in milliseconds.
+            uint32_t reserved;   // Reserved for future use (always zero).
+        }
+        Header;
+        // Fixed-size header of a record in the log file.
+
+        typedef struct Entry
+        {
+            uint64_t offset;     // Byte offset of the record in the log file.
+            int64_t  time;       // Unix time when the command was started.
+            uint32_t cwd_id;     // ID of the working directory.
+            int32_t  exit_code;  // Exit code of the command.
+            uint32_t duration;   // Duration of the command in milliseconds.
+            uint32_t length;     // Byte size of the command string.
+        }
+        Entry;
+        // Entry of the sidecar index file.
+
+        static constexpr uint32_t MAGIC = 0x484B534E;
+        // Record marker ("NSKH" in little endian).
+
+        static constexpr uint32_t CWD_UNKNOWN = 0;
+        // Working directory ID for the records whose directory is unknown (e.g. imported records).
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Constructors and destructors
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        explicit HistLog(const Path& path, HistWriter* writer = nullptr);
+        // [Abstract]
+        //   Constructor of HistLog. The log file, the index file (path + ".idx"), and the directory
+        //   table (path + ".dirs") are loaded if they exist. The index file is extended from the
+        //   log file if it does not cover all records of the log (e.g. the records appended after
+        //   the last load).
+        //
+        // [Args]
+        //   path   (const Path&): [IN] Path to the binary history log.
+        //   writer (HistWriter*): [IN] Background writer for the files (write synchronously if null).
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        void append(const String& command, const String& cwd, int64_t time, int32_t exit_code, uint32_t duration) noexcept;
+        // [Abstract]
+        //   Append a record to the log. The record is added to the index file at the next load.
+        //
+        // [Args]
+        //   command   (const String&): [IN] Command string.
+        //   cwd       (const String&): [IN] Working directory where the command was run.
+        //   time      (int64_t)      : [IN] Unix time when the command was started.
+        //   exit_code (int32_t)      : [IN] Exit code of the command.
+        //   duration  (uint32_t)     : [IN] Duration of the command in milliseconds.
+
+        uint32_t import_text(const Path& path) noexcept;
+        // [Abstract]
+        //   Import a plain text history file (one command per line) if the log is empty. The
+        //   emptiness is checked under the lock of the log, so the file is imported only once
+        //   even if multiple sessions start at the same time. The imported records have zero
+        //   time, unknown working directory, zero exit code, and zero duration.
+        //
+        // [Args]
+        //   path (const Path&): [IN] Path to the plain text history file.
+        //
+        // [Returns]
+        //   (uint32_t): Number of imported records.
+
+        size_t size(void) const noexcept;
+        // [Abstract]
+        //   Returns the number of records.
+        //
+        // [Returns]
+        //   (size_t): Number of records.
+
+        const Entry& entry(uint32_t index) const noexcept;
+        // [Abstract]
+        //   Returns the index entry (metadata) of the specified record.
+        //
+        // [Args]
+        //   index (uint32_t): [IN] Record index (0 is the oldest).
+        //
+        // [Returns]
+        //   (const HistLog::Entry&): Index entry.
+
+        const String& command(uint32_t index) const noexcept;
+        // [Abstract]
+        //   Returns the command string of the specified record.
+        //
+        // [Args]
+        //   index (uint32_t): [IN] Record index (0 is the oldest).
+        //
+        // [Returns]
+        //   (const String&): Command string.
+
+        const String& directory(uint32_t cwd_id) const noexcept;
+        // [Abstract]
+        //   Returns the working directory of the specified ID.
+        //
+        // [Args]
+        //   cwd_id (uint32_t): [IN] Working directory ID.
+        //
+        // [Returns]
+        //   (const String&): Working directory (empty if unknown).
+
+        uint32_t directory_id(const String& cwd) const noexcept;
+        // [Abstract]
+        //   Returns the ID of the given working directory.
+        //
+        // [Args]
+        //   cwd (const String&): [IN] Working directory.
+        //
+        // [Returns]
+        //   (uint32_t): Working directory ID (HistLog::CWD_UNKNOWN if not registered).
+
+        Pair<uint32_t, uint32_t> find_by_time(int64_t time_bgn, int64_t time_end) const noexcept;
+        // [Abstract]
+        //   Find records started in the time range [time_bgn, time_end) by binary search.
+        //   Records are assumed to be appended in chronological order.
+        //
+        // [Args]
+        //   time_bgn (int64_t): [IN] Beginning of the time range (inclusive).
+        //   time_end (int64_t): [IN] End of the time range (exclusive).
+        //
+        // [Returns]
+        //   (Pair<uint32_t, uint32_t>): Range of record indices [first, second).
+
+        const Vector<uint32_t>& find_by_dir(const String& cwd) const noexcept;
+        // [Abstract]
+        //   Find records which were run in the given working directory.
+        //
+        // [Args]
+        //   cwd (const String&): [IN] Working directory.
+        //
+        // [Returns]
+        //   (const Vector<uint32_t>&): Record indices in ascending order.
+
+        Vector<uint32_t> find_by_prefix(const String& prefix) const noexcept;
+        // [Abstract]
+        //   Find records whose command string starts with the given prefix by binary search.
+        //
+        // [Args]
+        //   prefix (const String&): [IN] Prefix of command strings.
+        //
+        // [Returns]
+        //   (Vector<uint32_t>): Record indices in ascending order.
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member variables
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        Path path_log, path_idx, path_dir;
+        // Paths to the log file, the index file, and the directory table.
+
+        HistWriter* writer;
+        // Background writer for the files.
+
+        uint64_t size_log;
+        // Byte size of the log file when loaded and appended by this session. This is used only
+        // for the in-memory entries because other sessions may append to the same log.
+
+        bool bulk;
+        // True while loading or importing records, where `by_prefix` is sorted once at the end.
+
+        Vector<Entry> entries;
+        // Index entries of all records.
+
+        Vector<String> commands;
+        // Command strings of all records.
+
+        Map<uint32_t, String> dirs;
+        // Directory table where the key is the working directory ID. The ID of a directory is the
+        // first ID from its hash which is not used by the directories listed before it in the
+        // directory table file, so that all sessions assign the same IDs.
+
+        Map<uint32_t, Vector<uint32_t>> by_dir;
+        // Record indices grouped by working directory ID.
+
+        Vector<uint32_t> by_prefix;
+        // Record indices sorted by command string.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        void load(void) noexcept;
+        // [Abstract]
+        //   Load the log file, the index file, and the directory table.
+
+        void write(const Path& path, const String& data) noexcept;
+        // [Abstract]
+        //   Append the given data to the file using the background writer if available.
+        //
+        // [Args]
+        //   path (const Path&)  : [IN] Path to target file.
+        //   data (const String&): [IN] Data to be appended.
+
+        void load_dirs(void) noexcept;
+        // [Abstract]
+        //   Load the directory table file, where the directories already loaded are skipped.
+
+        static uint32_t hash_dir(const String& cwd) noexcept;
+        // [Abstract]
+        //   Returns the FNV-1a hash of the path of the working directory, which is the first
+        //   candidate of its ID.
+        //
+        // [Args]
+        //   cwd (const String&): [IN] Working directory (non-empty).
+        //
+        // [Returns]
+        //   (uint32_t): Hash of the path (never be HistLog::CWD_UNKNOWN).
+
+        uint32_t probe_dir(const String& cwd) const noexcept;
+        // [Abstract]
+        //   Find the ID of the working directory from its hash by linear probing.
+        //
+        // [Args]
+        //   cwd (const String&): [IN] Working directory (non-empty).
+        //
+        // [Returns]
+        //   (uint32_t): Working directory ID if registered, otherwise the free ID for it.
+
+        uint32_t register_dir(const String& cwd) noexcept;
+        // [Abstract]
+        //   Register the given working directory to the directory table if not registered yet.
+        //   The directory table file is locked and read again before registering, so that the
+        //   directories registered by other sessions are taken into account.
+        //
+        // [Args]
+        //   cwd (const String&): [IN] Working directory.
+        //
+        // [Returns]
+        //   (uint32_t): Working directory ID.
+
+        void register_entry(const Entry& entry, const String& command) noexcept;
+        // [Abstract]
+        //   Register the given record to the in-memory lookup tables.
+        //
+        // [Args]
+        //   entry   (const HistLog::Entry&): [IN] Index entry.
+        //   command (const String&)        : [IN] Command string.
+
+        void sort_by_prefix(void) noexcept;
+        // [Abstract]
+        //   Sort the lookup table of prefixes after registering records in bulk.
+};
+
+#endif
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
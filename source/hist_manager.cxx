@@ -5,6 +5,10 @@
 // Include the primary header.
 #include "hist_manager.hxx"
 
+// Include the headers of STL.
+#include <cstdio>
+#include <sys/file.h>
+
 // Include the headers of custom modules.
 #include "config.hxx"
 #include "dtypes.hxx"
@@ -15,6 +19,8 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 HistManager::HistManager()
+    : writer(config.history_durability, config.history_sync_interval),
+      log(Path(replace(config.path_histlog, "~", getenv("HOME"))), &this->writer), offset(0)
 {   // {{{
 
     this->path = Path(replace(config.path_history, "~", getenv("HOME")));
@@ -24,9 +30,13 @@ HistManager::HistManager()
         std::filesystem::create_directories(this->path.parent_path());
 
     // Load file contents if exists.
-    if (std::filesystem::exists(this->path))
-        for (const String& line : read_lines(this->path.string()))
-            this->hists.emplace_back(line.c_str());
+    // This is the same as tailing the file from the beginning.
+    this->sync();
+
+    // Import the text history if the binary history log is not created yet. The log is checked
+    // again while importing, because other sessions may import it at the same time.
+    if ((this->log.size() == 0) and std::filesystem::exists(this->path))
+        this->log.import_text(this->path);
 
 }   // }}}
 
@@ -42,33 +52,56 @@ HistManager::~HistManager()
 void HistManager::append(const StringX& storage) noexcept
 {   // {{{
 
-    constexpr auto append_text = [](const Path& path, const String& str) noexcept -> void
-    // [Abstract]
-    //   Append a text to a file.
-    //
-    // [Args]
-    //   path (const Path&)  : [IN] Path to target file.
-    //   str  (const String&): [IN] string to write.
-    {
-        // Open the file with append mode.
-        FILE *ofp = fopen(path.c_str(), "at");
-        if (ofp == NULL)
-            return;
+    // Append to the member variable.
+    this->hists.push_back(storage);
 
-        // Write the given string.
-        fputs(str.c_str(), ofp);
-        fflush(ofp);
+    // Memorize the history to skip it when read back from the history file.
+    if (config.share_history)
+        this->unread_own.push_back(storage);
 
-        // Close the file.
-        fclose(ofp);
+    // Append to the history file on the background thread.
+    this->writer.write(this->path, storage.string() + '\n');
 
-    };
+}   // }}}
 
-    // Append to the member variable.
-    this->hists.push_back(storage);
+uint32_t HistManager::sync(void) noexcept
+{   // {{{
+
+    // Check the file size by stat at first, and do nothing if the file is not updated.
+    // This check is done for every prompt, therefore it should be cheap enough.
+    std::error_code ec;
+    const uintmax_t size = std::filesystem::file_size(this->path, ec);
+    if (ec or (size == this->offset))
+        return 0;
+
+    // Open the file with read mode.
+    FILE *fp = fopen(this->path.c_str(), "r");
+    if (fp == NULL)
+        return 0;
 
-    // Append to the history file.
-    append_text(this->path, storage.string() + '\n');
+    // Read the delta under the shared lock to avoid reading a line being written.
+    flock(fileno(fp), LOCK_SH);
+    const uint32_t count = this->read_delta(fp);
+    flock(fileno(fp), LOCK_UN);
+
+    // Close the file.
+    fclose(fp);
+
+    return count;
+
+}   // }}}
+
+void HistManager::record(const StringX& hist, const String& cwd, int64_t time, int32_t exit_code, uint32_t duration) noexcept
+{   // {{{
+
+    this->log.append(hist.string(), cwd, time, exit_code, duration);
+
+}   // }}}
+
+void HistManager::flush(void) noexcept
+{   // {{{
+
+    this->writer.flush();
 
 }   // }}}
 
@@ -79,4 +112,65 @@ const Deque<StringX>& HistManager::get_hists() const noexcept
 
 }   // }}}
 
+const HistLog& HistManager::get_log() const noexcept
+{   // {{{
+
+    return this->log;
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HistManager: Private member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t HistManager::read_delta(FILE* fp) noexcept
+{   // {{{
+
+    // Get the current file size.
+    fseek(fp, 0, SEEK_END);
+    const long size = ftell(fp);
+
+    // Reload all histories if the file was truncated or replaced by a smaller one.
+    if ((size < 0) or (static_cast<uint64_t>(size) < this->offset))
+    {
+        this->hists.clear();
+        this->offset = 0;
+    }
+
+    // Do nothing if no delta exists.
+    if (size <= static_cast<long>(this->offset))
+        return 0;
+
+    // Read only the delta, i.e. the bytes after the last read position.
+    String delta(static_cast<size_t>(size) - this->offset, '\0');
+    fseek(fp, static_cast<long>(this->offset), SEEK_SET);
+    delta.resize(fread(delta.data(), 1, delta.size(), fp));
+
+    // Parse the delta to lines. The incomplete line at the end (i.e. a line being written)
+    // is not consumed and will be read at the next time.
+    uint32_t count = 0;
+    String::size_type pos_bgn = 0;
+    for (String::size_type pos_end = delta.find('\n'); pos_end != String::npos; pos_end = delta.find('\n', pos_bgn))
+    {
+        const StringX line = StringX(delta.substr(pos_bgn, pos_end - pos_bgn).c_str());
+        pos_bgn = pos_end + 1;
+
+        // Skip the histories appended by this session because they are already stored.
+        if ((this->unread_own.size() > 0) and (this->unread_own.front() == line))
+        {
+            this->unread_own.pop_front();
+            continue;
+        }
+
+        this->hists.push_back(line);
+        ++count;
+    }
+
+    // Update the read position.
+    this->offset += pos_bgn;
+
+    return count;
+
+}   // }}}
+
 // vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
@@ -7,8 +7,13 @@
 #ifndef HIST_MANAGER_HXX
 #define HIST_MANAGER_HXX
 
+// Include the headers of STL.
+#include <cstdio>
+
 // Include the headers of custom modules.
 #include "dtypes.hxx"
+#include "hist_log.hxx"
+#include "hist_writer.hxx"
 #include "string_x.hxx"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -34,11 +39,36 @@ class HistManager
 
         void append(const StringX& hist) noexcept;
         // [Abstract]
-        //   Append the given history string.
+        //   Append the given history string. The history is written to the history file by
+        //   the background writer, so this function never blocks on the disk I/O. The history
+        //   file is locked while writing so that multiple sessions can share the same file.
         //
         // [Args]
         //   storage (const StringX&): History string to be appended.
 
+        uint32_t sync(void) noexcept;
+        // [Abstract]
+        //   Read the histories appended to the history file by the other sessions.
+        //   Only the delta from the last read position is parsed.
+        //
+        // [Returns]
+        //   (uint32_t): Number of the histories newly read.
+
+        void record(const StringX& hist, const String& cwd, int64_t time, int32_t exit_code, uint32_t duration) noexcept;
+        // [Abstract]
+        //   Record the given history string with metadata to the binary history log.
+        //
+        // [Args]
+        //   hist      (const StringX&): History string to be recorded.
+        //   cwd       (const String&) : Working directory where the command was run.
+        //   time      (int64_t)       : Unix time when the command was started.
+        //   exit_code (int32_t)       : Exit code of the command.
+        //   duration  (uint32_t)      : Duration of the command in milliseconds.
+
+        void flush(void) noexcept;
+        // [Abstract]
+        //   Wait until all pending histories are written to the files.
+
         const Deque<StringX>& get_hists() const noexcept;
         // [Abstract]
         //   Returns the histories stored in this class instance.
@@ -46,6 +76,13 @@ class HistManager
         // [Returns]
         //   (const Vector<StringX>&): A vector of histories.
 
+        const HistLog& get_log() const noexcept;
+        // [Abstract]
+        //   Returns the binary history log.
+        //
+        // [Returns]
+        //   (const HistLog&): The binary history log.
+
     private:
 
         ////////////////////////////////////////////////////////////////////////////////////////////
@@ -57,6 +94,34 @@ class HistManager
 
         Deque<StringX> hists;
         // A list of histories.
+
+        Deque<StringX> unread_own;
+        // Histories appended by this session that are not read back by `sync` yet.
+        // Used only in the shared history mode.
+
+        HistWriter writer;
+        // Background writer for the history files.
+
+        HistLog log;
+        // Binary history log with metadata.
+
+        uint64_t offset;
+        // Byte offset of the history file that is already read.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        uint32_t read_delta(FILE* fp) noexcept;
+        // [Abstract]
+        //   Read the lines appended after the last read position.
+        //   The caller should lock the file before calling this function.
+        //
+        // [Args]
+        //   fp (FILE*): [IN] File pointer of the history file.
+        //
+        // [Returns]
+        //   (uint32_t): Number of the lines newly read.
 };
 
 #endif
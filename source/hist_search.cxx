@@ -0,0 +1,278 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ source file: hist_search.cxx                                                             ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Include the primary header.
+#include "hist_search.hxx"
+
+// Include the headers of STL.
+#include <algorithm>
+#include <cstring>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Static functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static inline char fold_case(char c) noexcept
+// [Abstract]
+//   Convert an ASCII upper case to lower case.
+//
+// [Args]
+//   c (char): Input character.
+//
+// [Returns]
+//   (char): Lower case of the input if it is an ASCII upper case, otherwise the input itself.
+//
+{   // {{{
+
+    return (('A' <= c) and (c <= 'Z')) ? static_cast<char>(c + ('a' - 'A')) : c;
+
+}   // }}}
+
+static inline bool is_word_boundary(std::string_view text, size_t pos) noexcept
+// [Abstract]
+//   Returns true if the given position is the beginning of a word, including the upper case
+//   following a lower case (e.g. "N" of "RunNow").
+//
+// [Args]
+//   text (std::string_view): Target text.
+//   pos  (size_t)          : Byte position in the text.
+//
+// [Returns]
+//   (bool): True if the position is the beginning of a word.
+//
+{   // {{{
+
+    if (pos == 0)
+        return true;
+
+    const char prev = text[pos - 1], curr = text[pos];
+
+    return (std::strchr(" /-_.=:,;|&'\"", prev) != nullptr) or (('a' <= prev) and (prev <= 'z') and ('A' <= curr) and (curr <= 'Z'));
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HistSearch: Constructors
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HistSearch::HistSearch(void) : n_hists(0)
+{ /* Do nothing */ }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HistSearch: Member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HistSearch::update(const Deque<StringX>& hists) noexcept
+{   // {{{
+
+    // Rebuild the search target if the histories are truncated.
+    if (hists.size() < this->n_hists)
+        this->clear();
+
+    // Nothing to do if no history was appended.
+    if (hists.size() == this->n_hists)
+        return;
+
+    for (size_t index = this->n_hists; index < hists.size(); ++index)
+    {
+        const String line = hists[index].string();
+
+        // Update the sequence number if the history already exists.
+        const auto iter = this->ids.find(line);
+        if (iter != this->ids.end())
+        {
+            this->lasts[iter->second] = static_cast<uint32_t>(index);
+            continue;
+        }
+
+        // Otherwise register the history as a new entry.
+        this->ids[line] = static_cast<uint32_t>(this->lines.size());
+        this->masks.push_back(HistSearch::charmask(line));
+        this->lasts.push_back(static_cast<uint32_t>(index));
+        this->lines.push_back(line);
+    }
+
+    this->n_hists = hists.size();
+
+    // The matched set of the previous query is no longer complete.
+    this->query_prev.clear();
+    this->matched.clear();
+
+}   // }}}
+
+const Vector<uint32_t>& HistSearch::search(const String& query, uint16_t max_results) noexcept
+{   // {{{
+
+    this->scored.clear();
+    this->results.clear();
+
+    // Returns the most recent histories if the query is empty.
+    if (query.size() == 0)
+    {
+        for (uint32_t id = 0; id < this->lines.size(); ++id)
+            this->scored.emplace_back(0, id);
+
+        this->query_prev.clear();
+        this->matched.clear();
+    }
+    else
+    {
+        // Re-filter the previous matched set if the query extends the previous query,
+        // because a text which does not match the previous query never matches the new query.
+        const bool is_narrowing = (this->query_prev.size() > 0) and query.starts_with(this->query_prev);
+
+        // Compute the character mask of the query for the quick filter.
+        const uint64_t mask = HistSearch::charmask(query);
+
+        // Score the candidates which pass the quick filter.
+        const auto try_match = [this, &query, mask](uint32_t id) noexcept
+        {
+            if ((this->masks[id] & mask) != mask)
+                return;
+
+            const int32_t score = HistSearch::score(this->lines[id], query);
+            if (score >= 0)
+                this->scored.emplace_back(score, id);
+        };
+
+        if (is_narrowing) { for (uint32_t id : this->matched)                           try_match(id); }
+        else              { for (uint32_t id = 0; id < this->lines.size(); ++id) try_match(id); }
+
+        // Keep the matched set for the next query.
+        this->query_prev = query;
+        this->matched.clear();
+        for (const auto& [_, id] : this->scored)
+            this->matched.push_back(id);
+    }
+
+    // Select top-k results. Ties are broken by recency.
+    const auto greater = [this](const Pair<int32_t, uint32_t>& a, const Pair<int32_t, uint32_t>& b) noexcept -> bool
+    { return (a.first != b.first) ? (a.first > b.first) : (this->lasts[a.second] > this->lasts[b.second]); };
+
+    const size_t k = std::min(static_cast<size_t>(max_results), this->scored.size());
+    std::partial_sort(this->scored.begin(), this->scored.begin() + k, this->scored.end(), greater);
+
+    for (size_t n = 0; n < k; ++n)
+        this->results.push_back(this->scored[n].second);
+
+    return this->results;
+
+}   // }}}
+
+const String& HistSearch::get(uint32_t id) const noexcept
+{   // {{{
+
+    return this->lines[id];
+
+}   // }}}
+
+size_t HistSearch::size(void) const noexcept
+{   // {{{
+
+    return this->lines.size();
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HistSearch: Static member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int32_t HistSearch::score(std::string_view text, const String& query, Vector<uint16_t>* positions) noexcept
+{   // {{{
+
+    constexpr int32_t score_match       = 16;
+    constexpr int32_t bonus_consecutive = 8;
+    constexpr int32_t bonus_boundary    = 8;
+    constexpr int32_t penalty_gap_start = 3;
+    constexpr int32_t penalty_gap       = 1;
+
+    // Empty query matches everything.
+    if (query.size() == 0)
+        return 0;
+
+    // Use case-insensitive comparison if the query does not contain upper cases (smart case).
+    const bool ignore_case = std::none_of(query.begin(), query.end(), [](char c){ return ('A' <= c) and (c <= 'Z'); });
+    const auto equals = [ignore_case](char a, char b) noexcept -> bool
+    { return ignore_case ? (fold_case(a) == b) : (a == b); };
+
+    // Forward scan: find the end of the first occurrence of the query as a subsequence.
+    size_t pos_end = 0, qi = 0;
+    for (; (pos_end < text.size()) and (qi < query.size()); ++pos_end)
+        if (equals(text[pos_end], query[qi])) ++qi;
+
+    if (qi < query.size())
+        return -1;
+
+    // Backward scan: find the shortest occurrence which ends at the same position.
+    size_t pos_bgn = pos_end;
+    for (qi = query.size(); qi > 0; )
+        if (equals(text[--pos_bgn], query[qi - 1])) --qi;
+
+    // Compute the score of the occurrence in [pos_bgn, pos_end).
+    int32_t score = 0;
+    size_t  pos_prev = pos_bgn;
+    qi = 0;
+
+    if (positions != nullptr)
+        positions->clear();
+
+    for (size_t pos = pos_bgn; (pos < pos_end) and (qi < query.size()); ++pos)
+    {
+        if (not equals(text[pos], query[qi]))
+            continue;
+
+        score += score_match;
+
+        if ((qi > 0) and (pos == pos_prev + 1)) score += bonus_consecutive;
+        if (is_word_boundary(text, pos))         score += bonus_boundary;
+
+        if ((qi > 0) and (pos > pos_prev + 1))
+            score -= penalty_gap_start + penalty_gap * static_cast<int32_t>(pos - pos_prev - 2);
+
+        if (positions != nullptr)
+            positions->push_back(static_cast<uint16_t>(pos));
+
+        pos_prev = pos;
+        ++qi;
+    }
+
+    // Prefer the occurrence near to the beginning of the text.
+    score -= std::min(static_cast<int32_t>(pos_bgn), score_match - 1);
+
+    return std::max(score, 0);
+
+}   // }}}
+
+uint64_t HistSearch::charmask(std::string_view text) noexcept
+{   // {{{
+
+    uint64_t mask = 0;
+
+    // The characters are folded to lower case so that the mask can be used for both
+    // case-sensitive and case-insensitive search.
+    for (char c : text)
+        mask |= uint64_t(1) << (static_cast<uint8_t>(fold_case(c)) & 0x3F);
+
+    return mask;
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HistSearch: Private member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HistSearch::clear(void) noexcept
+{   // {{{
+
+    this->lines.clear();
+    this->masks.clear();
+    this->lasts.clear();
+    this->ids.clear();
+    this->matched.clear();
+    this->query_prev.clear();
+    this->n_hists = 0;
+
+}   // }}}
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
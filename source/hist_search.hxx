@@ -0,0 +1,152 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ header file: hist_search.hxx                                                             ///
+///                                                                                              ///
+/// This file defines the class `HistSearch` which provides the fuzzy history search. Histories  ///
+/// are matched as a subsequence of the query, scored, and the top-k results are selected. The   ///
+/// matched set is narrowed incrementally while the query grows.                                 ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef HIST_SEARCH_HXX
+#define HIST_SEARCH_HXX
+
+// Include the headers of STL.
+#include <cstdint>
+#include <string_view>
+
+// Include the headers of custom modules.
+#include "dtypes.hxx"
+#include "string_x.hxx"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Class definitions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class HistSearch
+{
+    public:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Constructors and destructors
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        HistSearch(void);
+        // [Abstract]
+        //   Default constructor of HistSearch.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        void update(const Deque<StringX>& hists) noexcept;
+        // [Abstract]
+        //   Update the search target using the given histories. The histories are assumed to be
+        //   only appended after the last update, therefore only the new histories are added.
+        //   The search target is rebuilt if the number of histories decreased.
+        //
+        // [Args]
+        //   hists (const Deque<StringX>&): Source of histories.
+
+        const Vector<uint32_t>& search(const String& query, uint16_t max_results) noexcept;
+        // [Abstract]
+        //   Search histories which contain the query as a subsequence. If the query extends the
+        //   previous query, only the previously matched histories are re-filtered.
+        //
+        // [Args]
+        //   query       (const String&): Search query.
+        //   max_results (uint16_t)     : Maximum number of results.
+        //
+        // [Returns]
+        //   (const Vector<uint32_t>&): IDs of the matched histories in descending order of score.
+
+        const String& get(uint32_t id) const noexcept;
+        // [Abstract]
+        //   Returns the history string of the given ID.
+        //
+        // [Args]
+        //   id (uint32_t): History ID returned by `search`.
+        //
+        // [Returns]
+        //   (const String&): History string.
+
+        size_t size(void) const noexcept;
+        // [Abstract]
+        //   Returns the number of unique histories.
+        //
+        // [Returns]
+        //   (size_t): Number of unique histories.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Static member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        static int32_t score(std::string_view text, const String& query, Vector<uint16_t>* positions = nullptr) noexcept;
+        // [Abstract]
+        //   Compute the fuzzy matching score of the given text. The query matches if all of its
+        //   characters appear in the text in the same order. Consecutive matches and matches at
+        //   the beginning of words get bonuses, and gaps between matches get penalties.
+        //   The comparison is case-insensitive if the query does not contain upper cases.
+        //
+        // [Args]
+        //   text      (std::string_view) : [IN ] Target text.
+        //   query     (const String&)    : [IN ] Search query.
+        //   positions (Vector<uint16_t>*): [OUT] Byte positions of matched characters (optional).
+        //
+        // [Returns]
+        //   (int32_t): Matching score (negative if not matched).
+
+        static uint64_t charmask(std::string_view text) noexcept;
+        // [Abstract]
+        //   Compute a bit mask of the characters contained in the text. It is used as a quick
+        //   filter; a text can match the query only if its mask contains the mask of the query.
+        //
+        // [Args]
+        //   text (std::string_view): Target text.
+        //
+        // [Returns]
+        //   (uint64_t): Bit mask of the contained characters.
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member variables
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        Vector<String> lines;
+        // Unique history strings.
+
+        Vector<uint64_t> masks;
+        // Character masks of the history strings (stored contiguously for the quick filter).
+
+        Vector<uint32_t> lasts;
+        // Sequence number of the last use of each history string.
+
+        Map<String, uint32_t> ids;
+        // Reverse lookup table of the history strings.
+
+        size_t n_hists;
+        // Number of histories which are already added.
+
+        String query_prev;
+        // Query of the previous search.
+
+        Vector<uint32_t> matched;
+        // IDs of the histories matched to the previous query.
+
+        Vector<Pair<int32_t, uint32_t>> scored;
+        // Scores and IDs of the matched histories (working buffer).
+
+        Vector<uint32_t> results;
+        // Top-k results of the previous search.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        void clear(void) noexcept;
+        // [Abstract]
+        //   Clear the search target and the cached results.
+};
+
+#endif
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
@@ -0,0 +1,200 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ source file: hist_writer.cxx                                                             ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Include the primary header.
+#include "hist_writer.hxx"
+
+// Include the headers of STL.
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Static functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void write_all(int fd, const String& data) noexcept
+// [Abstract]
+//   Write all the given data to the file descriptor while retrying partial writes.
+//
+// [Args]
+//   fd   (int)          : [IN] File descriptor opened with O_APPEND.
+//   data (const String&): [IN] Data to be written.
+//
+{   // {{{
+
+    size_t done = 0;
+
+    while (done < data.size())
+    {
+        const ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+
+        // Give up writing if an error other than interruption occurred.
+        if (n < 0 and errno == EINTR) continue;
+        if (n <= 0) return;
+
+        done += static_cast<size_t>(n);
+    }
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HistWriter: Constructors and destructors
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HistWriter::HistWriter(Durability durability, uint16_t interval)
+    : durability(durability), interval(interval), writing(false), stopping(false)
+{   // {{{
+
+    // Start the background thread.
+    this->worker = std::thread(&HistWriter::run, this);
+
+}   // }}}
+
+HistWriter::~HistWriter()
+{   // {{{
+
+    // Notify the background thread to stop.
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->cond.notify_all();
+
+    // Wait until all pending data are written.
+    this->worker.join();
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HistWriter: Member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HistWriter::write(const Path& path, const String& data) noexcept
+{   // {{{
+
+    // Queue the data.
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->pending.emplace_back(path, data);
+    }
+
+    // Wake up the background thread.
+    this->cond.notify_all();
+
+}   // }}}
+
+void HistWriter::flush(void) noexcept
+{   // {{{
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    this->cond.wait(lock, [this]{ return this->pending.empty() and (not this->writing); });
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// HistWriter: Private member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HistWriter::run(void) noexcept
+{   // {{{
+
+    // File descriptors which are kept open while the thread is running.
+    Map<String, int> fds;
+
+    // True if some data was written after the last fdatasync.
+    bool dirty = false;
+
+    // Time of the last fdatasync.
+    auto time_sync = std::chrono::steady_clock::now();
+
+    // Condition to wake up the thread.
+    const auto is_ready = [this]{ return this->stopping or (not this->pending.empty()); };
+
+    while (true)
+    {
+        // Batch of data to be written.
+        Vector<Pair<Path, String>> batch;
+
+        // Wait for the pending data, and take all of them as a batch.
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+
+            if ((this->durability == Durability::INTERVAL) and dirty)
+                this->cond.wait_for(lock, std::chrono::seconds(this->interval), is_ready);
+            else
+                this->cond.wait(lock, is_ready);
+
+            if (this->stopping and this->pending.empty())
+                break;
+
+            batch.swap(this->pending);
+            this->writing = true;
+        }
+
+        // Group the batch by file path while keeping the order of data.
+        Vector<Pair<Path, String>> groups;
+        for (const auto& [path, data] : batch)
+        {
+            auto iter = std::find_if(groups.begin(), groups.end(), [&path](const auto& group){ return group.first == path; });
+
+            if (iter == groups.end()) groups.emplace_back(path, data);
+            else                      iter->second += data;
+        }
+
+        // Write each group by one system call.
+        for (const auto& [path, data] : groups)
+        {
+            // Open the file if not opened yet.
+            if (not fds.contains(path.string()))
+                fds[path.string()] = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+
+            const int fd = fds[path.string()];
+            if (fd < 0)
+                continue;
+
+            // Lock the file so that the lines written by multiple sessions are not mixed.
+            flock(fd, LOCK_EX);
+            write_all(fd, data);
+            if (this->durability == Durability::BATCH)
+                fdatasync(fd);
+            flock(fd, LOCK_UN);
+
+            dirty = true;
+        }
+
+        // Call fdatasync periodically if the policy is INTERVAL.
+        const auto now = std::chrono::steady_clock::now();
+        if ((this->durability == Durability::INTERVAL) and dirty and (now - time_sync >= std::chrono::seconds(this->interval)))
+        {
+            for (const auto& [_, fd] : fds)
+                if (fd >= 0) fdatasync(fd);
+
+            dirty     = false;
+            time_sync = now;
+        }
+
+        // Notify the completion of writing.
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->writing = false;
+        }
+        this->cond.notify_all();
+    }
+
+    // Close all files. Unsynced data are synced before closing if required.
+    for (const auto& [_, fd] : fds)
+    {
+        if (fd < 0) continue;
+        if ((this->durability != Durability::NONE) and dirty) fdatasync(fd);
+        close(fd);
+    }
+
+}   // }}}
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
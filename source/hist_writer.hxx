@@ -0,0 +1,110 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ header file: hist_writer.hxx                                                             ///
+///                                                                                              ///
+/// This file defines the class `HistWriter` which appends data to history files on a background ///
+/// thread. Pending data are grouped and written by one system call for each file, so the        ///
+/// command loop never waits for the disk I/O.                                                   ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef HIST_WRITER_HXX
+#define HIST_WRITER_HXX
+
+// Include the headers of STL.
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// Include the headers of custom modules.
+#include "dtypes.hxx"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Class definitions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class HistWriter
+{
+    public:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Data types
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        enum class Durability { NONE, BATCH, INTERVAL };
+        // Durability policy of the written data.
+        //   * NONE    : Never call fdatasync (data is flushed by the OS).
+        //   * BATCH   : Call fdatasync after writing each batch.
+        //   * INTERVAL: Call fdatasync periodically if some data was written.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Constructors and destructors
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+         HistWriter(Durability durability, uint16_t interval);
+        ~HistWriter();
+        // [Abstract]
+        //   Constructor and destructor of HistWriter. The destructor writes all pending data
+        //   before stopping the background thread.
+        //
+        // [Args]
+        //   durability (Durability): [IN] Durability policy.
+        //   interval   (uint16_t)  : [IN] Interval of fdatasync in seconds (used only if INTERVAL).
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        void write(const Path& path, const String& data) noexcept;
+        // [Abstract]
+        //   Queue the given data to be appended to the file. This function returns immediately.
+        //
+        // [Args]
+        //   path (const Path&)  : [IN] Path to target file.
+        //   data (const String&): [IN] Data to be appended.
+
+        void flush(void) noexcept;
+        // [Abstract]
+        //   Wait until all pending data are written.
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member variables
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        Durability durability;
+        // Durability policy.
+
+        uint16_t interval;
+        // Interval of fdatasync in seconds.
+
+        Vector<Pair<Path, String>> pending;
+        // Data waiting to be written.
+
+        bool writing;
+        // True while the background thread is writing a batch.
+
+        bool stopping;
+        // True if the background thread should stop.
+
+        std::mutex mutex;
+        // Mutex for the pending data and the flags.
+
+        std::condition_variable cond;
+        // Condition variable to notify the pending data and the completion of writing.
+
+        std::thread worker;
+        // Background thread which writes the pending data.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        void run(void) noexcept;
+        // [Abstract]
+        //   Main loop of the background thread.
+};
+
+#endif
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
@@ -8,12 +8,18 @@
 #include "main.hxx"
 
 // Include the headers of STL.
+#include <chrono>
 #include <cstdio>
+#include <ctime>
+#include <future>
+#include <memory>
 #include <regex>
+#include <sys/wait.h>
 
 // Include the headers of custom modules.
 #include "config.hxx"
 #include "cmd_runner.hxx"
+#include "edit_helper.hxx"
 #include "hist_manager.hxx"
 #include "parse_args.hxx"
 #include "path_x.hxx"
@@ -62,18 +68,40 @@ static Tuple<String, String, String, String> get_prompt_strings(const TermSize&
 
 }   // }}}
 
-static void print_welcome_message()
+static int32_t get_exit_code(int32_t status)
 // [Abstract]
-//   Print welcome message to STDOUT.
+//   Convert the raw status returned by std::system to the exit code.
+//
+// [Args]
+//   status (int32_t): [IN] Raw status of the command.
+//
+// [Returns]
+//   (int32_t): Exit code of the command.
+//
+{   // {{{
+
+    // Convert the raw status to the exit code in the same manner with shells.
+    if      (WIFEXITED(status))   return WEXITSTATUS(status);
+    else if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+    else                          return status;
+
+}   // }}}
+
+static String get_welcome_message()
+// [Abstract]
+//   Get welcome message.
+//
+// [Returns]
+//   (String): Welcome message.
 //
 {   // {{{
 
     PathX path_welcome = PathX(config.path_plugins) / "welcome";
 
     if (path_welcome.exists())
-        std::printf("%s\n", run_command(path_welcome.string(), true).c_str());
+        return run_command(path_welcome.string(), true);
     else
-        std::printf("%s\n", "Welcome to NiShiKi!");
+        return "Welcome to NiShiKi!";
 
 }   // }}}
 
@@ -84,18 +112,35 @@ static void print_welcome_message()
 int32_t main(int32_t argc, char* const argv[])
 {   // {{{
 
-    // Instanciate necessary classes.
-    HistManager   histmn;
-    CommandRunner runner;
+    // Parse command line arguments.
+    // This should be done before starting worker threads because this function may exit.
+    Map<String, String> args = parse_args(argc, argv, VERSION);
 
     // Get terminal size.
     TermSize term_size = get_terminal_size();
 
-    // Parse command line arguments.
-    Map<String, String> args = parse_args(argc, argv, VERSION);
+    // Run the start-up procedures concurrently on worker threads, that is, loading histories
+    // (and then parsing options of the frequent commands), scanning PATH, and running the
+    // "welcome" and "getpstr" plugins. The first prompt will be shown when the prompt strings
+    // are ready, and histories are attached when loaded.
+    auto future_histmn  = std::async(std::launch::async, []{
+        auto histmn = std::make_unique<HistManager>();
+        EditHelper::prefetch_options(histmn->get_hists());
+        return histmn;
+    });
+    auto future_welcome = std::async(std::launch::async, get_welcome_message);
+    auto future_prompts = std::async(std::launch::async, get_prompt_strings, term_size);
+    EditHelper::prefetch_commands();
+
+    // Instanciate necessary classes.
+    std::unique_ptr<HistManager> histmn;
+    CommandRunner runner;
+
+    // Empty histories used until the history manager is loaded.
+    const Deque<StringX> hists_empty;
 
     // Show welcome message.
-    print_welcome_message();
+    std::printf("%s\n", future_welcome.get().c_str());
 
     // Initialize the left and right hand side strings.
     StringX lhs, rhs;
@@ -105,8 +150,16 @@ int32_t main(int32_t argc, char* const argv[])
 
     while (true)
     {
-        // Get prompt strings.
-        const auto [ps0, ps1i, ps1n, ps2] = get_prompt_strings(term_size);
+        // Attach the history manager if loading has finished.
+        if ((histmn == nullptr) and (future_histmn.wait_for(std::chrono::seconds(0)) == std::future_status::ready))
+            histmn = future_histmn.get();
+
+        // Read the histories appended by the other sessions.
+        if (config.share_history and (histmn != nullptr))
+            histmn->sync();
+
+        // Get prompt strings. The first prompt strings are computed on a worker thread.
+        const auto [ps0, ps1i, ps1n, ps2] = future_prompts.valid() ? future_prompts.get() : get_prompt_strings(term_size);
 
         // Print the zero-th prompt.
         std::puts("");
@@ -115,8 +168,13 @@ int32_t main(int32_t argc, char* const argv[])
 
         // Read user input. Returns value is lhs and rhs.
         // Use command runner's lhs and rhs string as a initial editing string.
-        std::tie(lhs, rhs) = readcmd(lhs, rhs, histmn.get_hists(), config.area_height, ps1i, ps1n,
-                                     ps2, config.histhint_pre, config.histhint_post, input_str);
+        std::tie(lhs, rhs) = readcmd(lhs, rhs, (histmn != nullptr) ? histmn->get_hists() : hists_empty, config.area_height,
+                                     ps1i, ps1n, ps2, config.histhint_pre, config.histhint_post, input_str,
+                                     (histmn != nullptr) ? &histmn->get_log() : nullptr);
+
+        // Wait for the history manager because the input should be stored to the histories.
+        if (histmn == nullptr)
+            histmn = future_histmn.get();
 
         // Concatenate the left and right hand side of the user input.
         StringX input = lhs + rhs;
@@ -128,7 +186,7 @@ int32_t main(int32_t argc, char* const argv[])
         // Append the user input to the history manager.
         // NOTE: Plugin commands (starts with "!") are ignored.
         if ((input.size() > 0) and (input[0].value != '!'))
-            histmn.append(input);
+            histmn->append(input);
 
         // Erase the zero-th prompt.
         if (ps0.size() > 0)
@@ -144,8 +202,22 @@ int32_t main(int32_t argc, char* const argv[])
         std::printf("%s%s %s%s", config.datetime_pre, get_date().c_str(), get_time().c_str(), config.datetime_post);
         std::printf(" %s\n", input.colorize().string().c_str());
 
+        // Memorize the metadata of the command.
+        const String  cwd       = get_cwd();
+        const int64_t time_bgn  = static_cast<int64_t>(std::time(nullptr));
+        const auto    clock_bgn = std::chrono::steady_clock::now();
+
         // Run command.
-        std::tie(lhs, rhs) = runner.run(input);
+        int32_t status = 0;
+        std::tie(lhs, rhs) = runner.run(input, &status);
+
+        // Record the command with metadata to the binary history log.
+        if ((input.size() > 0) and (input[0].value != '!'))
+        {
+            const auto clock_end = std::chrono::steady_clock::now();
+            const auto duration  = std::chrono::duration_cast<std::chrono::milliseconds>(clock_end - clock_bgn).count();
+            histmn->record(input, cwd, time_bgn, get_exit_code(status), static_cast<uint32_t>(duration));
+        }
     }
 
     // Show farewell message.
@@ -0,0 +1,293 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ source file: opt_cache.cxx                                                               ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Include the primary header.
+#include "opt_cache.hxx"
+
+// Include the headers of STL.
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Include the headers of custom modules.
+#include "utils.hxx"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Static variables
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef struct CacheLock
+{
+    int fd;  // File descriptor of the lock file (negative if not locked).
+
+    CacheLock(const Path& path) : fd(open((path.string() + ".lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644))
+    { if (this->fd >= 0) flock(this->fd, LOCK_EX); }
+
+    ~CacheLock() { if (this->fd >= 0) { flock(this->fd, LOCK_UN); close(this->fd); } }
+}
+CacheLock;
+// Exclusive lock of the cache file among the sessions while the object is alive. The lock is
+// taken on a sidecar file (path + ".lock") because the cache file is replaced when rewritten.
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Static functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static String make_key(const String& path) noexcept
+// [Abstract]
+//   Returns the key of the cache for the given binary.
+//
+// [Args]
+//   path (const String&): [IN] Path to the binary.
+//
+// [Returns]
+//   (String): Key of the cache (empty string if the binary is not an executable file).
+//
+{   // {{{
+
+    struct stat st;
+
+    if ((::stat(path.c_str(), &st) != 0) or (not S_ISREG(st.st_mode)) or ((st.st_mode & S_IXUSR) == 0))
+        return "";
+
+    return path + "\t" + std::to_string(st.st_ino) + "\t" + std::to_string(st.st_size) + "\t"
+         + std::to_string(st.st_mtim.tv_sec) + "." + std::to_string(st.st_mtim.tv_nsec);
+
+}   // }}}
+
+static String format_table(const String& key, const OptCache::Table& table) noexcept
+// [Abstract]
+//   Format the option table as a record of the cache file, that is, a header line "# <key>"
+//   followed by lines of the option name and description separated by a tab.
+//
+// [Args]
+//   key   (const String&)          : [IN] Key of the cache.
+//   table (const OptCache::Table&): [IN] Option table.
+//
+// [Returns]
+//   (String): Record of the cache file.
+//
+{   // {{{
+
+    String record = "# " + key + "\n";
+
+    for (const auto& [opt, desc] : table)
+        record += opt.string() + "\t" + desc.string() + "\n";
+
+    return record;
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// OptCache: Constructors
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+OptCache::OptCache(const Path& path) : path(path), loaded(false)
+{ /* Do nothing */ }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// OptCache: Member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool OptCache::get(const String& command, Table& table) noexcept
+{   // {{{
+
+    const String key = OptCache::resolve(command);
+    if (key.size() == 0)
+        return false;
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    // Load the cache file at the first lookup.
+    if (not this->loaded)
+        this->load();
+
+    const auto iter = this->tables.find(key);
+    if (iter == this->tables.end())
+        return false;
+
+    table = iter->second;
+
+    return true;
+
+}   // }}}
+
+OptCache::Table OptCache::put(const String& command, const String& help) noexcept
+{   // {{{
+
+    const Table  table = OptCache::parse(help);
+    const String key   = OptCache::resolve(command);
+
+    // Do not store the commands not found in PATH, and the commands without options (e.g. the
+    // command does not support "--help" or failed to run) which will be retried next time.
+    if ((key.size() == 0) or (table.size() == 0))
+        return table;
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    if (not this->loaded)
+        this->load();
+
+    this->tables[key] = table;
+
+    // Append the table to the cache file, which is never rewritten by other sessions meanwhile.
+    std::error_code ec;
+    std::filesystem::create_directories(this->path.parent_path(), ec);
+
+    const CacheLock lock_file(this->path);
+
+    if (FILE* fp = std::fopen(this->path.c_str(), "a"))
+    {
+        std::fputs(format_table(key, table).c_str(), fp);
+        std::fclose(fp);
+    }
+
+    return table;
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// OptCache: Static functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+OptCache::Table OptCache::parse(const String& help) noexcept
+{   // {{{
+
+    Table table;
+
+    for (String line : split(help, "\n"))
+    {
+        // Strip whitespaces from the line.
+        line = strip(line);
+
+        for (String elem : split(line, " "))
+        {
+            // Strip whitespaces from the token.
+            elem = strip(elem);
+
+            // Remove after comma if exists.
+            String::size_type pos_comma = elem.find(',');
+            if (pos_comma != String::npos)
+                elem.erase(pos_comma);
+
+            // Remove after equal sign if exists.
+            String::size_type pos_equal = elem.find('=');
+            if (pos_equal != String::npos)
+                elem.erase(pos_equal);
+
+            // Both the token and line starts with '-', then register the option to the table.
+            // Tabs are not allowed in the option name because it is the separator of the cache file.
+            if ((elem.size() > 0 and elem[0] == '-') and (line.size() > 0 and line[0] == '-') and (elem.find('\t') == String::npos))
+                table[StringX(elem.c_str())] = StringX(line.c_str());
+        }
+    }
+
+    return table;
+
+}   // }}}
+
+String OptCache::resolve(const String& command) noexcept
+{   // {{{
+
+    // Commands with a directory (e.g. "./configure") are not cached because they depend on the
+    // working directory and are likely to be scripts under development.
+    if ((command.size() == 0) or (command.find('/') != String::npos))
+        return "";
+
+    const char* env_path = std::getenv("PATH");
+    if (env_path == nullptr)
+        return "";
+
+    // Returns the first executable file in PATH, like shells do.
+    for (const String& dir : split(String(env_path), ":"))
+    {
+        const String key = make_key(dir + "/" + command);
+        if (key.size() > 0)
+            return key;
+    }
+
+    return "";
+
+}   // }}}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// OptCache: Private member functions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void OptCache::load(void) noexcept
+{   // {{{
+
+    this->loaded = true;
+
+    // The records appended by other sessions while reading and rewriting would be lost.
+    const CacheLock lock_file(this->path);
+
+    std::ifstream ifs(this->path);
+    if (not ifs)
+        return;
+
+    // Read the records. The later record overwrites the earlier one of the same key.
+    String   line, key;
+    uint32_t n_records = 0;
+
+    while (std::getline(ifs, line))
+    {
+        if (line.starts_with("# "))
+        {
+            key = line.substr(2);
+            this->tables[key].clear();
+            ++n_records;
+            continue;
+        }
+
+        const String::size_type pos_tab = line.find('\t');
+        if ((key.size() == 0) or (pos_tab == String::npos))
+            continue;
+
+        this->tables[key][StringX(line.substr(0, pos_tab).c_str())] = StringX(line.substr(pos_tab + 1).c_str());
+    }
+
+    // Drop the tables of the binaries which are updated or removed.
+    const size_t n_tables = this->tables.size();
+    std::erase_if(this->tables, [](const auto& item) noexcept
+    {
+        const String& key = item.first;
+        return make_key(key.substr(0, key.find('\t'))) != key;
+    });
+
+    // Rewrite the cache file if it contains outdated or duplicated records.
+    if ((this->tables.size() == n_tables) and (n_tables == n_records))
+        return;
+
+    // The temporary file has a unique name, so that it is never written by other sessions.
+    String path_tmp = this->path.string() + ".XXXXXX";
+
+    const int fd = mkstemp(path_tmp.data());
+    if (fd < 0)
+        return;
+
+    fchmod(fd, 0644);
+
+    if (FILE* fp = fdopen(fd, "w"))
+    {
+        for (const auto& [key, table] : this->tables)
+            std::fputs(format_table(key, table).c_str(), fp);
+
+        const bool failed = (std::fclose(fp) != 0) or (std::rename(path_tmp.c_str(), this->path.c_str()) != 0);
+        if (failed)
+            unlink(path_tmp.c_str());
+    }
+    else
+    {
+        close(fd);
+        unlink(path_tmp.c_str());
+    }
+
+}   // }}}
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
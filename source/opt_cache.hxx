@@ -0,0 +1,124 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// C++ header file: opt_cache.hxx                                                               ///
+///                                                                                              ///
+/// This file defines the class `OptCache` which stores the option tables parsed from the output ///
+/// of `<command> --help` to a cache file. Each table is keyed by the path to the binary found in ///
+/// PATH and its inode, size, and modification time, so the table is re-parsed only when the      ///
+/// binary is updated. The cache file is loaded at the first lookup.                             ///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef OPT_CACHE_HXX
+#define OPT_CACHE_HXX
+
+// Include the headers of STL.
+#include <mutex>
+
+// Include the headers of custom modules.
+#include "dtypes.hxx"
+#include "string_x.hxx"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Class definitions
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class OptCache
+{
+    public:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Data types
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        typedef Map<StringX, StringX> Table;
+        // Option table, i.e. a map of option names and their description lines.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Constructors and destructors
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        explicit OptCache(const Path& path);
+        // [Abstract]
+        //   Constructor of OptCache. The cache file is not read until the first lookup.
+        //
+        // [Args]
+        //   path (const Path&): [IN] Path to the cache file.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        bool get(const String& command, Table& table) noexcept;
+        // [Abstract]
+        //   Get the option table of the given command. This function is thread-safe.
+        //
+        // [Args]
+        //   command (const String&): [IN ] Command name.
+        //   table   (Table&)       : [OUT] Option table.
+        //
+        // [Returns]
+        //   (bool): True if the table is cached and the binary is not updated.
+
+        Table put(const String& command, const String& help) noexcept;
+        // [Abstract]
+        //   Parse the help message of the command, and store the option table to the cache file.
+        //   Commands which are not found in PATH (e.g. aliases) are not stored.
+        //   This function is thread-safe.
+        //
+        // [Args]
+        //   command (const String&): [IN] Command name.
+        //   help    (const String&): [IN] Output of `<command> --help`.
+        //
+        // [Returns]
+        //   (Table): Parsed option table.
+
+        static Table parse(const String& help) noexcept;
+        // [Abstract]
+        //   Parse the help message and returns the option table.
+        //
+        // [Args]
+        //   help (const String&): [IN] Output of `<command> --help`.
+        //
+        // [Returns]
+        //   (Table): Option table.
+
+        static String resolve(const String& command) noexcept;
+        // [Abstract]
+        //   Find the command in PATH and returns the key of the cache, that is, the path to the
+        //   binary and its inode, size, and modification time.
+        //
+        // [Args]
+        //   command (const String&): [IN] Command name.
+        //
+        // [Returns]
+        //   (String): Key of the cache (empty string if the command is not found in PATH).
+
+    private:
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member variables
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        Path path;
+        // Path to the cache file.
+
+        bool loaded;
+        // True if the cache file is loaded.
+
+        Map<String, Table> tables;
+        // Option tables where the key is the result of `resolve`.
+
+        std::mutex mutex;
+        // Mutex for the member variables.
+
+        ////////////////////////////////////////////////////////////////////////////////////////////
+        // Private member functions
+        ////////////////////////////////////////////////////////////////////////////////////////////
+
+        void load(void) noexcept;
+        // [Abstract]
+        //   Load the cache file. The file is rewritten if it contains outdated tables.
+};
+
+#endif
+
+// vim: expandtab tabstop=4 shiftwidth=4 fdm=marker
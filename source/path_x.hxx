@@ -59,13 +59,16 @@ class PathX : public Path
         // [Returns]
         //   (bool): True if the filepath exists.
 
-        Vector<String> listdir(uint32_t n_max_items = 128) const noexcept;
+        Vector<String> listdir(uint32_t n_max_items = 128, const String& prefix = "", bool show_dot = true) const noexcept;
         // [Abstract]
-        //   Returns a list of names of the entries in the given directory path.
-        //   The list is sorted in ascending order.
+        //   Returns a list of names of the entries in the given directory path which start with
+        //   the given prefix. The list is sorted in ascending order (directories first).
+        //   The directory listing is cached, see `dir_cache.hxx` for details.
         //
         // [Args]
-        //   n_max_items (uint32_t): [IN] The maximum number of items to be listed.
+        //   n_max_items (uint32_t)     : [IN] The maximum number of items to be listed.
+        //   prefix      (const String&): [IN] Prefix of the names to be listed.
+        //   show_dot    (bool)         : [IN] List dot files even if the prefix is not a dot file.
         //
         // [Returns]
         //   (std::vector<std::string>): List of names of the entries.
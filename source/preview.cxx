@@ -6,11 +6,12 @@
 #include "preview.hxx"
 
 // Include the headers of STL.
-#include <filesystem>
 #include <regex>
 
 // Include the headers of custom modules.
+#include "co_proc.hxx"
 #include "config.hxx"
+#include "file_stat.hxx"
 #include "file_type.hxx"
 #include "utils.hxx"
 
@@ -28,7 +29,7 @@ Vector<StringX> preview(const String& path, uint16_t width, uint16_t height) noe
     Vector<StringX> result;
 
     // Do nothing if the target file path does not exist.
-    if (not std::filesystem::exists(path))
+    if (not get_file_stat(path).exists)
         return result;
 
     // Compute mime type of the preview target.
@@ -38,6 +39,27 @@ Vector<StringX> preview(const String& path, uint16_t width, uint16_t height) noe
     const auto predicate = [mime_type](const Pair<String, String>& pv)
     { return regex_match(mime_type, std::regex(pv.first)); };
 
+    // Ask the matched plugin first. Nothing is previewed if the plugin does not answer in time.
+    const auto pl_iter = std::find_if(config.preview_plugins.begin(), config.preview_plugins.end(), predicate);
+    if (pl_iter != config.preview_plugins.end())
+    {
+        CoProc& plugin = get_coproc(pl_iter->second, config.plugin_timeout);
+
+        String output;
+        const uint64_t id = plugin.submit({"preview", path, mime_type, std::to_string(width), std::to_string(height)});
+        if (not plugin.poll(id, config.plugin_timeout, output))
+        {
+            plugin.cancel(id);
+            return result;
+        }
+
+        for (const String& line : split(output, "\n"))
+            if (result.size() < height)
+                result.push_back(StringX(replace(line, "\t", "    ").c_str()).clip(width));
+
+        return result;
+    }
+
     // Find matched preview method.
     const auto pv_iter = std::find_if(config.previews.begin(), config.previews.end(), predicate);
 
@@ -12,6 +12,8 @@
 #include "config.hxx"
 #include "edit_helper.hxx"
 #include "hist_comp.hxx"
+#include "hist_index.hxx"
+#include "hist_search.hxx"
 #include "term_reader.hxx"
 #include "term_writer.hxx"
 #include "text_buffer.hxx"
@@ -24,6 +26,15 @@
 
 static bool is_not_interrupted = true;
 
+static HistCompleter histcmp;
+// History completer which is shared by all prompts so that the index is updated incrementally.
+
+static HistSearch histsrch;
+// Fuzzy history search which is shared by all prompts so that the histories are added incrementally.
+
+static HistIndex histidx;
+// Substring index of histories which is shared by all prompts so that the histories are added incrementally.
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Static functions
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -49,6 +60,157 @@ static StringX generate_keybind_command(CharX cx, const StringX& lhs, const Stri
 
 }   // }}}
 
+static StringX format_search_result(const String& line, const String& query, bool fuzzy, bool selected, uint16_t width) noexcept
+// [Abstract]
+//   Format a result of the history search as a completion line. The line is truncated to
+//   the given width, and the matched characters are highlighted.
+//
+// [Args]
+//   line     (const String&): [IN] History string.
+//   query    (const String&): [IN] Search query.
+//   fuzzy    (bool)         : [IN] True if the query is matched as a subsequence (otherwise substring).
+//   selected (bool)         : [IN] True if the line is selected.
+//   width    (uint16_t)     : [IN] Width of the terminal.
+//
+// [Returns]
+//   (StringX): Formatted completion line.
+//
+{   // {{{
+
+    // Truncate the line to fit the terminal width (2 columns are used by the marker).
+    StringX line_x = StringX(line.c_str());
+    if (line_x.width() > width - 2)
+        line_x = line_x.chunk(width - 3).front() + CharX('~');
+
+    const String text = line_x.string();
+
+    // Get the byte positions of the matched characters.
+    Vector<uint16_t> positions;
+    if (fuzzy)
+        HistSearch::score(line, query, &positions);
+    else if (const size_t pos = line.find(query); (query.size() > 0) and (pos != String::npos))
+        for (size_t n = 0; n < query.size(); ++n)
+            positions.push_back(static_cast<uint16_t>(pos + n));
+
+    // Insert the escape sequences around the matched characters.
+    String result = selected ? "\x1B[7m> " : "  ";
+    result += highlight(text, positions, config.histsearch_match_pre, config.histsearch_match_post);
+    result += "\x1B[0m";
+
+    return StringX(result.c_str());
+
+}   // }}}
+
+static bool search_history(TermReader& reader, const TermWriter& writer, const TermSize& area, const Deque<StringX>& hists,
+                           bool fuzzy, const StringX& query_ini, StringX& input, StringX& output) noexcept
+// [Abstract]
+//   Run the history search mode. The histories are filtered every time the query is edited,
+//   and the selected history is returned when ENTER is pressed. The fuzzy search lists the
+//   histories by the matching score, and the substring search (reverse-i-search) lists them
+//   from the most recent one.
+//
+// [Args]
+//   reader    (TermReader&)          : [IN ] Terminal reader.
+//   writer    (const TermWriter&)    : [IN ] Terminal writer.
+//   area      (const TermSize&)      : [IN ] Size of drawing area.
+//   hists     (const Deque<StringX>&): [IN ] History strings.
+//   fuzzy     (bool)                 : [IN ] Fuzzy search if true, otherwise substring search.
+//   query_ini (const StringX&)       : [IN ] Initial value of the query.
+//   input     (StringX&)             : [IN ] Input string for testing purpose.
+//   output    (StringX&)             : [OUT] Selected history.
+//
+// [Returns]
+//   (bool): True if a history was selected.
+//
+{   // {{{
+
+    // Add the new histories to the search target.
+    if (fuzzy) histsrch.update(hists);
+    else       histidx.update(hists);
+
+    const StringX ps_x = StringX(fuzzy ? config.histsearch_prompt : config.histsearch_prompt_substr);
+    StringX query = query_ini;
+    size_t  selected = 0, top = 0;
+
+    while (is_not_interrupted)
+    {
+        // Search histories. The matched set of the fuzzy search is narrowed incrementally while
+        // the query grows, and the substring search is answered by the suffix array.
+        const String query_str = query.string();
+        const Vector<uint32_t> results = fuzzy ? histsrch.search(query_str, config.histsearch_max_results)
+                                               : histidx.find(query_str, config.histsearch_max_results);
+
+        // Returns the history string of the result.
+        const auto get = [fuzzy](uint32_t id) noexcept -> String { return fuzzy ? histsrch.get(id) : histidx.get(id); };
+
+        // Keep the selected line inside of the results and the visible area.
+        const size_t n_visible = std::max<size_t>(area.rows, 2) - 2;
+        selected = std::min(selected, std::max<size_t>(results.size(), 1) - 1);
+        if (selected <  top)             top = selected;
+        if (selected >= top + n_visible) top = selected + 1 - n_visible;
+
+        // Create the completion lines: the number of results and the visible results.
+        Vector<StringX> clines;
+        clines.emplace_back((String(config.histhint_pre) + "  " + std::to_string(results.size()) + "/"
+                             + std::to_string(fuzzy ? histsrch.size() : hists.size()) + config.histhint_post).c_str());
+        for (size_t n = top; (n < results.size()) and (n < top + n_visible); ++n)
+            clines.push_back(format_search_result(get(results[n]), query_str, fuzzy, n == selected, area.cols));
+
+        // Re-draw terminal.
+        writer.write(query, StringX(""), ps_x, ps_x, clines, StringX(""), "", "");
+
+        // Get user input.
+        const CharX cx = (input.size() > 0) ? input.pop(StringX::Pos::BEGIN) : reader.getch(is_not_interrupted);
+
+        switch (cx.value)
+        {
+            // Cancel the search if Ctrl-C, Ctrl-D, Ctrl-U or ESC is pressed.
+            case 0x03:
+            case 0x04:
+            case 0x15:
+            case 0x1B:
+                return false;
+
+            // Select the history if ENTER is pressed.
+            case '\n':
+            case '\r':
+                if (results.size() == 0) return false;
+                output = StringX(get(results[selected]).c_str());
+                return true;
+
+            // Edit the query.
+            case 0x08:
+            case 0x7F:
+                query.pop(StringX::Pos::END);
+                selected = top = 0;
+                break;
+
+            // Move the selection.
+            case 0x09:
+            case 0x0E:
+            case 0x12:
+            case CHARX_VALUE_KEY_DOWN:
+                ++selected;
+                break;
+            case 0x10:
+            case CHARX_VALUE_KEY_UP:
+                selected = (selected > 0) ? (selected - 1) : 0;
+                break;
+
+            // Otherwise append the character to the query if printable.
+            default:
+                if ((cx.value >= 0x20) and ((cx.value & 0xFF) != 0x1B))
+                {
+                    query += cx;
+                    selected = top = 0;
+                }
+        }
+    }
+
+    return false;
+
+}   // }}}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Published functions
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -56,7 +218,7 @@ static StringX generate_keybind_command(CharX cx, const StringX& lhs, const Stri
 Tuple<StringX, StringX>
 readcmd(const StringX& lhs_ini, const StringX& rhs_ini, const Deque<StringX>& hists,
         uint8_t area_height, const String& ps1i, const String& ps1n, const String& ps2,
-        const char* histhint_pre, const char* histhint_post, StringX& input)
+        const char* histhint_pre, const char* histhint_post, StringX& input, const HistLog* log)
 {   // {{{
 
     // Get terminal size.
@@ -70,7 +232,6 @@ readcmd(const StringX& lhs_ini, const StringX& rhs_ini, const Deque<StringX>& hi
     TermWriter    writer  = TermWriter(area);
     EditHelper    helper  = EditHelper(area);
     TextBuffer    buffer  = TextBuffer(lhs_ini, rhs_ini, hists);
-    HistCompleter histcmp = HistCompleter();
 
     // Initialize the completion candidates.
     Vector<StringX> comps;
@@ -83,10 +244,16 @@ readcmd(const StringX& lhs_ini, const StringX& rhs_ini, const Deque<StringX>& hi
     // Set editing mode to INSERT mode.
     buffer.set_mode(TextBuffer::Mode::INSERT);
 
-    // Update cache for history completions.
-    // This function should be called for every time when starting editing because
-    // previous editing result should be contained in the history cache.
-    histcmp.set_hists(buffer.get_storage());
+    // Update the index for history completions.
+    // Only the histories appended after the previous call are indexed.
+    histcmp.update(hists, log);
+    histcmp.set_cwd(get_cwd());
+
+    // Update the target of the substring search. The suffix array is built on the background
+    // thread when the histories are loaded, so that the first search does not scan them all.
+    histidx.update(hists);
+    if (histidx.size_indexed() == 0)
+        histidx.compact();
 
     // Set signal handler for SIGINT.
     signal(SIGINT, signal_handler);
@@ -103,13 +270,15 @@ readcmd(const StringX& lhs_ini, const StringX& rhs_ini, const Deque<StringX>& hi
 
         // Compute complete candidate if real-time completion is enabled.
         if (config.realtime_completion)
-            comps = helper.candidate(lhs);
+            comps = helper.candidate(lhs, false);
 
         // Re-draw terminal.
         writer.write(lhs, rhs, ps1_x, ps2_x, comps, histcmp.complete(lhs), histhint_pre, histhint_post);
 
         // Get user input.
-        const CharX cx = (input.size() > 0) ? input.pop(StringX::Pos::BEGIN) : reader.getch(is_not_interrupted);
+        // The reader wakes up to redraw the candidates when the completion provider finished.
+        const auto  wakeup = [&helper]() noexcept -> bool { return helper.is_ready(); };
+        const CharX cx     = (input.size() > 0) ? input.pop(StringX::Pos::BEGIN) : reader.getch(is_not_interrupted, wakeup);
 
         // Exit if one of the step key is typed.
         if (config.keybinds.contains(cx.value))
@@ -121,6 +290,13 @@ readcmd(const StringX& lhs_ini, const StringX& rhs_ini, const Deque<StringX>& hi
         // Process input character.
         switch (cx.value)
         {
+            // Redraw if woken up by the completion provider, where the result of the provider is
+            // collected here unless the real-time completion collects it at the next loop.
+            case 0x00:
+                if (not config.realtime_completion)
+                    comps = helper.candidate(lhs, false);
+                break;
+
             case 0x03:
                 kill(getpid(), SIGINT);
                 break;
@@ -130,11 +306,22 @@ readcmd(const StringX& lhs_ini, const StringX& rhs_ini, const Deque<StringX>& hi
                 buffer.set(StringX("^D"), StringX(""));
                 goto end_of_the_function;
 
-            // Execute completion if Ctrl-I (= horizontal tab) is pressed.
+            // Execute completion if Ctrl-I (= horizontal tab) is pressed. The provider is waited
+            // only once per keystroke, and the candidates of the completed text are shown when
+            // the provider finishes.
             case 0x09:
                 helper.candidate(lhs);
                 buffer.set(helper.complete(lhs), rhs);
-                comps = helper.candidate(lhs);
+                comps = helper.candidate(lhs, false);
+                break;
+
+            // Show the previous/next page of the completion candidates.
+            case CHARX_VALUE_KEY_PGUP:
+                comps = helper.scroll(-1);
+                break;
+
+            case CHARX_VALUE_KEY_PGDN:
+                comps = helper.scroll(1);
                 break;
 
             // History completion if Ctrl-N is pressed.
@@ -142,6 +329,24 @@ readcmd(const StringX& lhs_ini, const StringX& rhs_ini, const Deque<StringX>& hi
                 buffer.set(lhs + histcmp.complete(lhs) + CharX(' '), rhs);
                 break;
 
+            // Fuzzy history search if Ctrl-U is pressed.
+            case 0x15:
+            {
+                StringX hist;
+                if (search_history(reader, writer, area, hists, true, lhs + rhs, input, hist))
+                    buffer.set(hist, StringX(""));
+                break;
+            }
+
+            // Substring history search (reverse-i-search) if Ctrl-R is pressed.
+            case 0x12:
+            {
+                StringX hist;
+                if (search_history(reader, writer, area, hists, false, lhs + rhs, input, hist))
+                    buffer.set(hist, StringX(""));
+                break;
+            }
+
             // Exit function if ENTER is pressed.
             case '\n':
             case '\r':
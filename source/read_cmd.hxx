@@ -9,6 +9,7 @@
 
 // Include the headers of custom modules.
 #include "dtypes.hxx"
+#include "hist_log.hxx"
 #include "string_x.hxx"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -18,7 +19,8 @@
 Tuple<StringX, StringX>
 readcmd(const StringX& lhs_ini, const StringX& rhs_ini, const Deque<StringX>& hists,
         uint8_t area_height, const String& ps1i, const String& ps1n, const String& ps2,
-        const char* histhint_pre, const char* histhint_post, StringX& input_str);
+        const char* histhint_pre, const char* histhint_post, StringX& input_str,
+        const HistLog* log = nullptr);
 // [Abstract]
 //   Read user input with rich interface.
 //
@@ -33,6 +35,7 @@ readcmd(const StringX& lhs_ini, const StringX& rhs_ini, const Deque<StringX>& hi
 //   histhint_pre  (const char*)          : 
 //   histhint_post (const char*)          : 
 //   input_str     (const char*)          : 
+//   log           (const HistLog*)       : Binary history log used for ranking history hints.
 //
 // [Returns]
 //   (Tuple<StringX, StringX>): Returned pair of left and right hand side.
@@ -76,7 +76,7 @@ TermReader::~TermReader(void)
 // TermReader: Member functions
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-CharX TermReader::getch(const bool& is_not_interrupted) noexcept
+CharX TermReader::getch(const bool& is_not_interrupted, const std::function<bool(void)>& wakeup) noexcept
 {   // {{{
 
     // Read new characters from STDIN of no data remained in the buffer.
@@ -89,7 +89,11 @@ CharX TermReader::getch(const bool& is_not_interrupted) noexcept
         //   * The terminal attributes are changed by the constructor of this class.
         //   * The last byte of the buffer should be kept as zero.
         while (is_not_interrupted and (read(STDIN_FILENO, buffer, this->buffer_size - 1) == 0))
-        { /* Do nothing, just repeat the "read" function if timed out. */ }
+        {
+            // Wake up the caller if requested (e.g. to redraw the completion candidates).
+            if (wakeup and wakeup())
+                return CharX();
+        }
     }
 
     // Construct a new character from the buffer.
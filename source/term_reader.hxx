@@ -8,6 +8,7 @@
 #define TERM_READER_HXX
 
 // Include the headers of STL.
+#include <functional>
 #include <termios.h>
 
 // Include the headers of custom modules.
@@ -34,14 +35,16 @@ class TermReader
         // Member functions
         ////////////////////////////////////////////////////////////////////////////////////////////
 
-        CharX getch(const bool& is_not_interrupted) noexcept;
+        CharX getch(const bool& is_not_interrupted, const std::function<bool(void)>& wakeup = nullptr) noexcept;
         // [Abstract]
         //   Get valid UTF-8 character from STDIN and returns it. If the acquired character is
         //   registered in the keybind, convert the character to a binded string (most of the
         //   binded string will be added to the stack).
         //
         // [Args]
-        //   is_not_interrupted (bool): This variable will be false if interrupted.
+        //   is_not_interrupted (bool)    : This variable will be false if interrupted.
+        //   wakeup             (function): Optional function which is called while waiting input.
+        //                                  A null character (value 0) is returned if it returns true.
         //
         // [Returns]
         //   (CharX): Captured character.
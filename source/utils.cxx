@@ -6,6 +6,7 @@
 #include "utils.hxx"
 
 // Include the headers of STL.
+#include <bit>
 #include <fstream>
 #include <random>
 #include <unistd.h>
@@ -15,110 +16,118 @@
 // Utility functions
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Vector<StringX> column(const Vector<StringX>& texts, uint16_t width, uint16_t height, uint16_t margin) noexcept
+Vector<StringX> column(const Vector<StringX>& texts, uint16_t width, uint16_t height, uint16_t margin, size_t* n_shown) noexcept
 {   // {{{
 
-    constexpr auto get_shape = [](const Vector<uint16_t>& ws, uint16_t w, uint16_t m, uint16_t row) noexcept -> Pair<uint16_t, bool>
+    // Prepare output lines.
+    Vector<StringX> lines(height);
+
+    if (n_shown != nullptr)
+        *n_shown = 0;
+
+    // Do nothing if no text is given.
+    if ((texts.size() == 0) or (height == 0))
+        return lines;
+
+    // Get width of each text.
+    const Vector<uint16_t> ws = transform<StringX, uint16_t>(texts, [](const StringX& sx) { return sx.width(); });
+    const size_t           n  = ws.size();
+
+    // Build the sparse table of the range maxima of the widths, i.e. table[k][i] is the maximum
+    // width of the texts in [i, i + 2^k), so that the width of any column is found in O(1).
+    Vector<Vector<uint16_t>> table = {ws};
+    for (size_t half = 1; 2 * half <= n; half *= 2)
+    {
+        const Vector<uint16_t>& prev = table.back();
+
+        Vector<uint16_t> curr(n - 2 * half + 1);
+        for (size_t idx = 0; idx < curr.size(); ++idx)
+            curr[idx] = std::max(prev[idx], prev[idx + half]);
+
+        table.push_back(std::move(curr));
+    }
+
+    const auto get_max = [&table](size_t idx_bgn, size_t idx_end) noexcept -> uint16_t
+    // [Abstract]
+    //   Returns the maximum width of the texts in [idx_bgn, idx_end).
+    {
+        const size_t k = std::bit_width(idx_end - idx_bgn) - 1;
+        return std::max(table[k][idx_bgn], table[k][idx_end - (static_cast<size_t>(1) << k)]);
+    };
+
+    const auto get_shape = [&](size_t row) noexcept -> Pair<size_t, bool>
     // [Abstract]
-    //   Compute shape of column style display.
+    //   Compute shape of column style display. Each column costs O(1) and the columns are at
+    //   least `margin` wide, so the cost is bounded by both of n / row and width / margin.
     //
     // [Args]
-    //   ws  (const Vector<uint16_t>&): [IN] Length of each text.
-    //   w   (uint16_t)               : [IN] Maximum width of display.
-    //   m   (uint16_t)               : [IN] Minimum margin between each text.
-    //   row (uint16_t)               : [IN] Number of rows.
+    //   row (size_t): [IN] Number of rows.
     //
     // [Returns]
-    //   (Pair<uint16_t, bool>): A pair of (number of columns, true if all texts can be shown).
+    //   (Pair<size_t, bool>): A pair of (number of columns, true if all texts can be shown).
     {
-        uint16_t wid_total = 0;
+        size_t wid_total = 0;
 
-        // Create columns and append them to each line.
-        for (uint16_t col = 0; true; ++col)
+        for (size_t col = 0; true; ++col)
         {
             // Compute start/end index of the texts used in the current column
-            const uint16_t idx_bgn = col * row;
-            const uint16_t idx_end = std::min(static_cast<uint16_t>(idx_bgn + row), static_cast<uint16_t>(ws.size()));
-
-            // Compute maximum width of texts used in the current column.
-            const uint16_t wid_max = *std::max_element(ws.begin() + idx_bgn, ws.begin() + idx_end);
+            const size_t idx_bgn = col * row;
+            const size_t idx_end = std::min(idx_bgn + row, n);
 
             // Increment of width by this column.
-            const uint16_t wid_inc = ((col > 0) ? m : 0) + wid_max;
+            const size_t wid_inc = ((col > 0) ? margin : 0) + get_max(idx_bgn, idx_end);
 
             // Exit if the current width exceeds the maximum width.
-            if ((wid_total + wid_inc) >= w)
-                return Pair<uint16_t, bool>(std::max(static_cast<uint16_t>(1), col), false);
+            if ((wid_total + wid_inc) >= width)
+                return Pair<size_t, bool>(std::max(static_cast<size_t>(1), col), false);
 
             // Exit if all text was used.
-            if (idx_end == ws.size())
-                return Pair<uint16_t, bool>(static_cast<uint16_t>(col + 1), true);
+            if (idx_end == n)
+                return Pair<size_t, bool>(col + 1, true);
 
             // Update current width.
             wid_total += wid_inc;
         }
     };
 
-    constexpr auto get_optimal_height = [get_shape](const Vector<uint16_t>& ws, uint16_t w, uint16_t h, uint16_t m) noexcept -> Pair<uint16_t, int16_t>
-    // [Abstract]
-    //   Compute optimal shape (rows and columns) of column style display.
-    //
-    // [Args]
-    //   texts  (const Vector<StringX>&): [IN] Input texts.
-    //   width  (uint16_t)              : [IN] Maximum width of display.
-    //   height (uint16_t)              : [IN] Maximum height of display.
-    //   margin (uint16_t)              : [IN] Minimum margin between each text.
-    //
-    // [Returns]
-    //   (Pair<uint16_t, uint16_t>): A pair of (rows of the optimal shape, columns of the optimal shape).
+    // Compute optimal shape, i.e. the minimum rows which can show all texts, or the maximum
+    // height if no such rows exist.
+    size_t rows = height, cols = 0;
+    for (size_t row = 1; row <= height; ++row)
     {
-        for (uint16_t row = 1; row < h; ++row)
-        {
-            // Compute shape for each row.
-            const auto& [col, finished] = get_shape(ws, w, m, row);
+        const auto& [col, finished] = get_shape(row);
 
-            // Immediately determine optimal shape if all texts can be shown.
-            if (finished)
-                return Pair<uint16_t, uint16_t>(row, col);
+        if (finished or (row == height))
+        {
+            rows = row;
+            cols = col;
+            break;
         }
-
-        // Compute column if row is equal with the maximum height.
-        const auto& [col, _] = get_shape(ws, w, m, h);
-
-        return Pair<uint16_t, uint16_t>(h, col);
-    };
-
-    // Prepare output lines.
-    Vector<StringX> lines;
-    for (uint16_t row = 0; row < height; ++row)
-        lines.emplace_back();
-
-    // Do nothing if no text is given.
-    if (texts.size() == 0)
-        return lines;
-
-    // Get width of each text.
-    Vector<uint16_t> ws = transform<StringX, uint16_t>(texts, [](const StringX& sx) { return sx.width(); });
-
-    // Compute optimal shape (rows and columns).
-    const auto& [rows, cols] = get_optimal_height(ws, width, height, margin);
+    }
 
     // Initialize total width.
-    uint16_t width_total = 0;
+    size_t width_total = 0;
 
-    // Create columns and append them to each line.
-    for (uint16_t col = 0; col < cols; ++col)
+    // Create columns and append them to each line in place, without temporary strings.
+    for (size_t col = 0; col < cols; ++col)
     {
         // Compute start/end index of the texts used in the current column
-        const uint16_t idx_bgn = col * rows;
-        const uint16_t idx_end = std::min(static_cast<uint16_t>(idx_bgn + rows), static_cast<uint16_t>(ws.size()));
+        const size_t idx_bgn = col * rows;
+        const size_t idx_end = std::min(idx_bgn + rows, n);
 
         // Compute maximum width of texts used in the current column.
-        const uint16_t wid_max = *std::max_element(ws.begin() + idx_bgn, ws.begin() + idx_end);
+        const size_t wid_max = get_max(idx_bgn, idx_end);
 
-        // Append texts to each line.
-        for (uint16_t idx = idx_bgn; idx < idx_end; ++idx)
-            lines[idx % rows] += texts[idx] + CharX(' ') * (wid_max + margin - ws[idx]);
+        // Append texts and paddings to each line.
+        for (size_t idx = idx_bgn; idx < idx_end; ++idx)
+        {
+            StringX& line = lines[idx - idx_bgn];
+            line.insert(line.end(), texts[idx].begin(), texts[idx].end());
+            line.insert(line.end(), wid_max + margin - ws[idx], CharX(' '));
+        }
+
+        if (n_shown != nullptr)
+            *n_shown = idx_end;
 
         // Update total width.
         width_total += wid_max + margin;
@@ -152,6 +161,17 @@ void drop_whitespace_tokens(Vector<StringX>& tokens) noexcept
 
 };  // }}}
 
+String get_cwd(void) noexcept
+{   // {{{
+
+    // Get current working directory without throwing exception.
+    std::error_code ec;
+    const Path cwd = std::filesystem::current_path(ec);
+
+    return ec ? String("") : cwd.string();
+
+}   // }}}
+
 String get_date(void) noexcept
 {   // {{{
 
@@ -219,44 +239,41 @@ String get_time(void) noexcept
 
 }   // }}}
 
-Vector<StringX> get_system_commands(void) noexcept
+String highlight(const String& text, const Vector<uint16_t>& positions, const String& pre, const String& post, size_t offset) noexcept
 {   // {{{
 
-    Vector<StringX> result;
+    // Returns true if the byte is a continuation byte of a UTF-8 character.
+    const auto is_continuation = [&text](size_t pos) noexcept -> bool
+    { return (pos < text.size()) and ((static_cast<uint8_t>(text[pos]) & 0xC0) == 0x80); };
 
-    // Split PATH by ':'.
-    Vector<String> target_paths = split(String(std::getenv("PATH")), ":");
-
-    // Remove duplicated taregt path.
-    target_paths.erase(std::unique(target_paths.begin(), target_paths.end()), target_paths.end());
+    String result;
+    size_t pos_next = 0;
 
-    // Search all directories in PATH and get all executable files.
-    for (const String& path : target_paths)
+    for (const uint16_t pos : positions)
     {
-        // Skip if the path is not a directory.
-        if (std::filesystem::is_directory(path))
-        {
-            // Appand all files in the directory.
-            for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(path))
-            {
-                // Skip if the path is not a regular file or symbolic link.
-                if (entry.is_regular_file() or entry.is_symlink())
-                {
-                    // Get command name.
-                    StringX cmd = StringX(entry.path().filename().c_str());
-
-                    // Add the command name.
-                    result.emplace_back(cmd);
-                }
-            }
-        }
-    }
+        size_t pos_bgn = offset + pos;
+
+        // Skip the bytes of the character which is already decorated.
+        if (pos_bgn < pos_next)
+            continue;
+
+        if (pos_bgn >= text.size())
+            break;
 
-    // Sort the array of command names.
-    std::sort(result.begin(), result.end());
+        // Extend the matched byte to the whole character.
+        while ((pos_bgn > pos_next) and is_continuation(pos_bgn))
+            --pos_bgn;
+
+        size_t pos_end = pos_bgn + 1;
+        while (is_continuation(pos_end))
+            ++pos_end;
+
+        result += text.substr(pos_next, pos_bgn - pos_next);
+        result += pre + text.substr(pos_bgn, pos_end - pos_bgn) + post;
+        pos_next = pos_end;
+    }
 
-    // Remove duplicated command names.
-    result.erase(std::unique(result.begin(), result.end()), result.end());
+    result += text.substr(pos_next);
 
     return result;
 
@@ -19,15 +19,16 @@
 // Utility functions
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-Vector<StringX> column(const Vector<StringX>& texts, uint16_t width, uint16_t height, uint16_t margin = 3) noexcept;
+Vector<StringX> column(const Vector<StringX>& texts, uint16_t width, uint16_t height, uint16_t margin = 3, size_t* n_shown = nullptr) noexcept;
 // [Abstract]
 //   Format strings in the column style.
 //
 // [Args]
-//   texts  (const Vector<StringX>&): [IN] Input texts.
-//   width  (uint16_t)              : [IN] Maximum width of display.
-//   height (uint16_t)              : [IN] Maximum height of display.
-//   margin (uint16_t)              : [IN] Minimum margin between each text.
+//   texts   (const Vector<StringX>&): [IN ] Input texts.
+//   width   (uint16_t)              : [IN ] Maximum width of display.
+//   height  (uint16_t)              : [IN ] Maximum height of display.
+//   margin  (uint16_t)              : [IN ] Minimum margin between each text.
+//   n_shown (size_t*)               : [OUT] Number of the texts shown in the lines (optional).
 //
 // [Returns]
 //   (Vector<StringX>): Formated strings in column style.
@@ -77,12 +78,20 @@ String get_time(void) noexcept;
 // [Returns]
 //   (String): Time string.
 
-std::vector<StringX> get_system_commands(void) noexcept;
+String highlight(const String& text, const Vector<uint16_t>& positions, const String& pre, const String& post, size_t offset = 0) noexcept;
 // [Abstract]
-//   Get a list of all available commands in the system.
+//   Insert the given strings around the matched characters, where the whole UTF-8 character is
+//   decorated even if only some bytes of the character are matched.
+//
+// [Args]
+//   text      (const String&)          : [IN] Target string.
+//   positions (const Vector<uint16_t>&): [IN] Byte positions of the matched characters in ascending order.
+//   pre       (const String&)          : [IN] String inserted before each matched character.
+//   post      (const String&)          : [IN] String inserted after each matched character.
+//   offset    (size_t)                 : [IN] Byte offset added to the positions.
 //
 // [Returns]
-//   (std::vector<StringX>): List of available command names.
+//   (String): Decorated string.
 
 Vector<String> read_lines(const String& path) noexcept;
 // [Abstract]
@@ -4,14 +4,33 @@
 
 // Include the headers of STL.
 #include <cstdio>
+#include <chrono>
 #include <ctime>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 // Include the headers of custom modules.
+#include "cmd_index.hxx"
+#include "cmd_pool.hxx"
+#include "co_proc.hxx"
+#include "comp_rules.hxx"
+#include "config.hxx"
+#include "dir_cache.hxx"
+#include "dir_walker.hxx"
+#include "edit_helper.hxx"
+#include "file_stat.hxx"
 #include "file_type.hxx"
+#include "git_index.hxx"
+#include "hist_comp.hxx"
+#include "hist_index.hxx"
+#include "hist_log.hxx"
+#include "hist_manager.hxx"
+#include "hist_search.hxx"
+#include "opt_cache.hxx"
 #include "path_x.hxx"
 #include "preview.hxx"
 #include "read_cmd.hxx"
@@ -107,6 +126,242 @@ static void test_CharX()
 
 }   // }}}
 
+static void test_CmdIndex()
+{   // {{{
+
+    // Print header.
+    print_header("Unit test for CmdIndex class");
+
+    // Returns all names in the sorted order.
+    const auto get_names = [](const CmdIndex::Commands& commands) noexcept -> Vector<String>
+    {
+        Vector<String> names;
+        for (uint32_t idx = 0; idx < commands->offsets.size(); ++idx)
+            names.emplace_back(CmdIndex::name(*commands, idx));
+        return names;
+    };
+
+    // Prepare two directories of commands.
+    const Path path_dir = Path("/tmp") / ("nishiki_" + get_random_string(16));
+    std::filesystem::create_directories(path_dir / "bin1" / "subdir");
+    std::filesystem::create_directories(path_dir / "bin2");
+    for (const char* name : {"bin1/foo", "bin1/bar", "bin2/foo", "bin2/baz"})
+        fclose(fopen((path_dir / name).c_str(), "wt"));
+
+    const String bin1 = (path_dir / "bin1").string();
+    const String bin2 = (path_dir / "bin2").string();
+    const String none = (path_dir / "not_exist").string();
+
+    CmdIndex index;
+
+    // Test 1: sorted and unique names of files, where directories are excluded.
+    const CmdIndex::Commands commands = index.get(bin1 + ":" + none + ":" + bin2 + ":" + bin1);
+    assert((get_names(commands) == Vector<String>{"bar", "baz", "foo"}));
+
+    // Test 2: the same names are shared while nothing is modified.
+    assert(index.get(bin1 + ":" + none + ":" + bin2 + ":" + bin1) == commands);
+
+    // Test 3: the modified directory is read again.
+    fclose(fopen((path_dir / "bin2" / "qux").c_str(), "wt"));
+    assert((get_names(index.get(bin1 + ":" + bin2)) == Vector<String>{"bar", "baz", "foo", "qux"}));
+
+    // Test 4: the changes of PATH are reflected.
+    assert((get_names(index.get(bin2)) == Vector<String>{"baz", "foo", "qux"}));
+    assert(index.get("")->offsets.size() == 0);
+
+    // Test 5: range of the names which start with the prefix.
+    const CmdIndex::Commands all = index.get(bin1 + ":" + bin2);
+    assert((CmdIndex::range(*all, "ba") == Pair<uint32_t, uint32_t>{0, 2}));
+    assert((CmdIndex::range(*all, "foo") == Pair<uint32_t, uint32_t>{2, 3}));
+    assert((CmdIndex::range(*all, "") == Pair<uint32_t, uint32_t>{0, 4}));
+    assert((CmdIndex::range(*all, "c").first == CmdIndex::range(*all, "c").second));
+    assert((CmdIndex::range(*all, "zzz") == Pair<uint32_t, uint32_t>{4, 4}));
+
+    // Test 6: EditHelper completes the common prefix of all matched commands.
+    for (const char* name : {"bin1/gitk", "bin1/gitx", "bin1/gizmo"})
+        fclose(fopen((path_dir / name).c_str(), "wt"));
+
+    const String env_path = std::getenv("PATH");
+    setenv("PATH", bin1.c_str(), 1);
+    EditHelper helper({1, 4});
+    assert(helper.candidate(StringX("gi")).size() == 1);
+    assert(helper.complete(StringX("gi")) == StringX("gi"));
+    helper.candidate(StringX("git"));
+    assert(helper.complete(StringX("git")) == StringX("git"));
+    helper.candidate(StringX("giz"));
+    assert(helper.complete(StringX("giz")) == StringX("gizmo "));
+
+    // Test 7: fuzzy matching of the commands.
+    config.fuzzy_completion = true;
+    EditHelper helper_fuzzy({8, 80});
+    helper_fuzzy.candidate(StringX("gz"));
+    assert(helper_fuzzy.complete(StringX("gz")) == StringX("gizmo "));
+    helper_fuzzy.candidate(StringX("gt"));
+    assert(helper_fuzzy.complete(StringX("gt")) == StringX("gt"));
+    helper_fuzzy.candidate(StringX("gtk"));
+    assert(helper_fuzzy.complete(StringX("gtk")) == StringX("gitk "));
+    config.fuzzy_completion = false;
+    setenv("PATH", env_path.c_str(), 1);
+
+    // Clean up.
+    std::filesystem::remove_all(path_dir);
+
+}   // }}}
+
+static void test_CmdPool()
+{   // {{{
+
+    // Print header.
+    print_header("Unit test for CmdPool class");
+
+    CmdPool pool(2);
+    String  output;
+
+    // Test 1: get the output of a command.
+    const uint64_t id1 = pool.submit("echo hello");
+    assert(pool.poll(id1, 5.0, output) and (output == "hello\n"));
+    assert(not pool.poll(id1, 0.0, output));
+
+    // Test 2: the request of the same command is shared while running.
+    const uint64_t id2 = pool.submit("sleep 0.2; echo shared");
+    assert(pool.submit("sleep 0.2; echo shared") == id2);
+    assert(id2 > id1);
+    assert(not pool.finished(id2));
+    assert(pool.poll(id2, 5.0, output) and (output == "shared\n"));
+
+    // Test 3: cancelled request is killed and its output is discarded.
+    const auto     start = std::chrono::steady_clock::now();
+    const uint64_t id3   = pool.submit("sleep 10; echo never");
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    pool.cancel(id3);
+    assert(not pool.poll(id3, 1.0, output));
+    assert(pool.poll(pool.submit("echo next"), 5.0, output) and (output == "next\n"));
+    assert(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+
+}   // }}}
+
+static void test_CoProc()
+{   // {{{
+
+    // Print header.
+    print_header("Unit test for CoProc class");
+
+    // Prepare plugins which echo the fields of the requests, and which exit after an answer.
+    const Path path_dir = Path("/tmp") / ("nishiki_" + get_random_string(16));
+    std::filesystem::create_directories(path_dir);
+
+    std::ofstream(path_dir / "echo.sh") << "while IFS= read -r line; do\n"
+                                        << "  id=${line%%\"$(printf '\\t')\"*}; rest=${line#*\"$(printf '\\t')\"}\n"
+                                        << "  case \"$rest\" in sleep*) sleep 10;; esac\n"
+                                        << "  printf '%s\\t%s\\n%s\\t%s\\n%s\\n' \"$id\" \"$rest\" \"$id\" \"$$\" \"$id\"\n"
+                                        << "done\n";
+    std::ofstream(path_dir / "once.sh") << "IFS= read -r line; printf '%s\\tonce\\n%s\\n' \"${line%%\"$(printf '\\t')\"*}\" \"${line%%\"$(printf '\\t')\"*}\"\n";
+
+    String output;
+
+    // Test 1: escape and unescape the special characters.
+    assert(CoProc::escape("a\tb\nc\\d") == "a\\tb\\nc\\\\d");
+    assert(CoProc::unescape(CoProc::escape("a\tb\nc\\d\\t")) == "a\tb\nc\\d\\t");
+
+    // Test 2: the requests are answered by the same process.
+    CoProc plugin("sh '" + (path_dir / "echo.sh").string() + "'", 1.0);
+    const uint64_t id1 = plugin.submit({"complete", "a b"});
+    assert(plugin.poll(id1, 5.0, output));
+    const Vector<String> lines1 = split(output, "\n");
+    assert((lines1.size() == 2) and (lines1[0] == "complete\ta b"));
+
+    const uint64_t id2 = plugin.submit({"x\ty"});
+    assert((id2 > id1) and plugin.poll(id2, 5.0, output));
+    const Vector<String> lines2 = split(output, "\n");
+    assert((lines2.size() == 2) and (lines2[0] == "x\ty") and (lines2[1] == lines1[1]));
+    assert(not plugin.poll(id2, 0.0, output));
+
+    // Test 3: the plugin which does not answer within the timeout is killed at the next request,
+    // and the cancelled response is discarded.
+    const uint64_t id3 = plugin.submit({"sleep"});
+    assert(not plugin.poll(id3, 0.1, output));
+    plugin.cancel(id3);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+
+    const auto     start = std::chrono::steady_clock::now();
+    const uint64_t id4   = plugin.submit({"next"});
+    assert(plugin.poll(id4, 5.0, output) and (split(output, "\n")[0] == "next"));
+    assert(split(output, "\n")[1] != lines1[1]);
+    assert(not plugin.poll(id3, 0.0, output));
+    assert(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+
+    // Test 4: the plugin which exited is restarted at the next request.
+    CoProc once("sh '" + (path_dir / "once.sh").string() + "'", 1.0);
+    assert(once.poll(once.submit({"a"}), 5.0, output) and (output == "once"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    assert(once.poll(once.submit({"b"}), 5.0, output) and (output == "once"));
+
+    // Test 5: the request to the plugin which cannot start finishes with an empty response.
+    CoProc broken("exit 1", 1.0);
+    assert(broken.poll(broken.submit({"a"}), 5.0, output) and output.empty());
+
+    // Test 6: the "compgen" plugin answers by the completion specs of bash, and answers nothing
+    // for the commands which have no spec.
+    std::ofstream(path_dir / "specs.bash") << "_foo() { COMPREPLY=($(compgen -W 'alpha beta --color=auto' -- \"$2\")); }\n"
+                                           << "complete -F _foo foo\n"
+                                           << "complete -W 'red green' color\n";
+
+    CoProc compgen("../plugins/compgen '" + (path_dir / "specs.bash").string() + "'", 5.0);
+    assert(compgen.poll(compgen.submit({"complete", path_dir.string(), "foo", ""}), 5.0, output) and (output == "alpha\nbeta\n--color=auto"));
+    assert(compgen.poll(compgen.submit({"complete", path_dir.string(), "foo", "x", "--color=a"}), 5.0, output) and (output == "--color=auto"));
+    assert(compgen.poll(compgen.submit({"complete", path_dir.string(), "color", "g"}), 5.0, output) and (output == "green"));
+    assert(compgen.poll(compgen.submit({"complete", path_dir.string(), "bar", "a"}), 5.0, output) and output.empty());
+
+    std::filesystem::remove_all(path_dir);
+
+}   // }}}
+
+static void test_CompRules()
+{   // {{{
+
+    typedef EditHelper::CompType CompType;
+
+    // Print header.
+    print_header("Unit test for CompRules class");
+
+    // Prepare completion rules.
+    const CompRules rules({
+        {{"git", "checkout", ">>", ".*"}, CompType::SHELL,   "branch", 60, {".git/HEAD"}},
+        {{"git", ".*"},                   CompType::SUBCMD,  "subcmd"},
+        {{"ssh", "[a-z]+"},               CompType::SHELL,   "host"},
+        {{"[./~].*"},                     CompType::PATH,    ""},
+        {{".+"},                          CompType::COMMAND, ""},
+        {{">>", "-.*"},                   CompType::OPTION,  ""},
+        {{">>", "FILE", ""},              CompType::PREVIEW, ""},
+        {{">>", ".*"},                    CompType::PATH,    "any"},
+    });
+
+    // Test 1: literal, prefix, character set, and regular expression patterns.
+    assert((rules.find({"git", "checkout", "ma"}) == Tuple<CompType, String>(CompType::SHELL, "branch")));
+    assert((rules.find({"git", "checkout", "-b", "ma"}) == Tuple<CompType, String>(CompType::SHELL, "branch")));
+    assert((rules.find({"git", "st"}) == Tuple<CompType, String>(CompType::SUBCMD, "subcmd")));
+    assert((rules.find({"ssh", "host"}) == Tuple<CompType, String>(CompType::SHELL, "host")));
+    assert((rules.find({"ssh", "Host"}) == Tuple<CompType, String>(CompType::PATH, "any")));
+    assert((rules.find({"./sour"}) == Tuple<CompType, String>(CompType::PATH, "")));
+    assert((rules.find({"ls"}) == Tuple<CompType, String>(CompType::COMMAND, "")));
+    assert((rules.find({"ls", "--col"}) == Tuple<CompType, String>(CompType::OPTION, "")));
+
+    // Test 2: ">>" requires at least one token after the head patterns.
+    assert((rules.find({"git", "checkout"}) == Tuple<CompType, String>(CompType::SUBCMD, "subcmd")));
+    assert((rules.find({}) == Tuple<CompType, String>(CompType::NONE, "")));
+
+    // Test 3: "FILE" pattern matches with existing files.
+    assert((rules.find({"cat", "Makefile", ""}) == Tuple<CompType, String>(CompType::PREVIEW, "")));
+    assert((rules.find({"cat", "not_exist", ""}) == Tuple<CompType, String>(CompType::PATH, "any")));
+
+    // Test 4: the matched rule has the cache policy.
+    assert(rules.find_rule({"git", "checkout", "ma"})->ttl == 60);
+    assert((rules.find_rule({"git", "checkout", "ma"})->watch == Vector<String>{".git/HEAD"}));
+    assert(rules.find_rule({"ssh", "host"})->ttl == 0);
+    assert(rules.find_rule({}) == nullptr);
+
+}   // }}}
+
 static void test_FileType()
 {   // {{{
 
@@ -125,6 +380,676 @@ static void test_FileType()
 
 }   // }}}
 
+static void test_file_stat()
+{   // {{{
+
+    // Print header.
+    print_header("Unit test for file_stat functions");
+
+    // Prepare a temporary directory and an executable file in it.
+    const Path path_dir  = Path("/tmp") / ("nishiki_" + get_random_string(16));
+    const Path path_file = path_dir / "run.sh";
+    std::filesystem::create_directory(path_dir);
+    FILE *ofp = fopen(path_file.c_str(), "wt");
+    fputs("#!/bin/sh\n", ofp);
+    fclose(ofp);
+    std::filesystem::permissions(path_file, std::filesystem::perms::owner_all);
+
+    // Test 1: metadata of files and directories.
+    const float ttl = config.stat_cache_ttl;
+    config.stat_cache_ttl = 3600;
+    assert(get_file_stat(path_file).exists);
+    assert(get_file_stat(path_file).is_exec);
+    assert(not get_file_stat(path_file).is_dir);
+    assert(get_file_stat(path_dir / "").is_dir);
+    assert(get_file_stat("/tmp").is_dir);
+    assert(not get_file_stat(path_dir / "not_exist").exists);
+    assert(not get_file_stat("").exists);
+
+    // Test 2: the cached metadata is used within the TTL, and dropped by clearing the cache.
+    std::filesystem::remove(path_file);
+    assert(get_file_stat(path_file).exists);
+    clear_file_stat_cache();
+    assert(not get_file_stat(path_file).exists);
+
+    // Test 3: the cached metadata is invalidated by the modification of the parent directory.
+    config.stat_cache_ttl = 0;
+    ofp = fopen(path_file.c_str(), "wt");
+    fclose(ofp);
+    assert(get_file_stat(path_file).exists);
+    assert(not get_file_stat(path_file).is_exec);
+
+    // Test 4: the relative paths are resolved from the current working directory.
+    config.stat_cache_ttl = 3600;
+    const Path cwd = std::filesystem::current_path();
+    std::filesystem::current_path(path_dir);
+    assert(get_file_stat("run.sh").exists);
+    std::filesystem::create_directory(path_dir / "sub");
+    std::filesystem::current_path(path_dir / "sub");
+    assert(not get_file_stat("run.sh").exists);
+    std::filesystem::current_path(cwd);
+    config.stat_cache_ttl = ttl;
+
+    // Clean up.
+    std::filesystem::remove_all(path_dir);
+    clear_file_stat_cache();
+
+}   // }}}
+
+static void test_dir_cache()
+{   // {{{
+
+    // Print header.
+    print_header("Unit test for dir_cache functions");
+
+    // Prepare a temporary directory.
+    const Path path_dir = Path("/tmp") / ("nishiki_" + get_random_string(16));
+    std::filesystem::create_directory(path_dir);
+    std::filesystem::create_directory(path_dir / "beta");
+    std::filesystem::create_directory(path_dir / ".git");
+    for (const char* name : {"alpha", "alpine", "bravo", ".bashrc"})
+        fclose(fopen((path_dir / name).c_str(), "wt"));
+
+    // Test 1: directories first, and filtered by the prefix.
+    assert((list_directory(path_dir, "", 128, false) == Vector<String>{"beta/", "alpha", "alpine", "bravo"}));
+    assert((list_directory(path_dir, "", 128, true) == Vector<String>{".git/", "beta/", ".bashrc", "alpha", "alpine", "bravo"}));
+    assert((list_directory(path_dir, "alp", 128, false) == Vector<String>{"alpha", "alpine"}));
+    assert((list_directory(path_dir, "b", 128, false) == Vector<String>{"beta/", "bravo"}));
+    assert((list_directory(path_dir, ".", 128, false) == Vector<String>{".git/", ".bashrc"}));
+    assert((list_directory(path_dir, "x", 128, false).size() == 0));
+    assert((list_directory(path_dir / "not_exist", "", 128, false).size() == 0));
+
+    // Test 2: the maximum number of items is applied after filtering.
+    assert((list_directory(path_dir, "a", 1, false) == Vector<String>{"alpha"}));
+
+    // Test 3: symbolic links to directories are listed as directories.
+    std::filesystem::create_directory_symlink(path_dir / "beta", path_dir / "link");
+    clear_dir_cache();
+    assert((list_directory(path_dir, "", 128, false) == Vector<String>{"beta/", "link/", "alpha", "alpine", "bravo"}));
+
+    // Test 4: the cached listing is used within the TTL, and invalidated by the modification.
+    const float ttl = config.stat_cache_ttl;
+    config.stat_cache_ttl = 3600;
+    fclose(fopen((path_dir / "alps").c_str(), "wt"));
+    assert((list_directory(path_dir, "alp", 128, false).size() == 2));
+    config.stat_cache_ttl = 0;
+    assert((list_directory(path_dir, "alp", 128, false) == Vector<String>{"alpha", "alpine", "alps"}));
+
+    // Test 5: the relative paths are resolved from the current working directory.
+    config.stat_cache_ttl = 3600;
+    const Path cwd = std::filesystem::current_path();
+    std::filesystem::current_path(path_dir);
+    assert((list_directory(".", "al", 128, false) == Vector<String>{"alpha", "alpine", "alps"}));
+    std::filesystem::current_path(path_dir / "beta");
+    assert((list_directory(".", "al", 128, false).size() == 0));
+    assert((list_directory("..", "al", 128, false).size() == 3));
+    std::filesystem::current_path(cwd);
+    config.stat_cache_ttl = ttl;
+
+    // Clean up.
+    std::filesystem::remove_all(path_dir);
+    clear_dir_cache();
+
+}   // }}}
+
+static void test_DirWalker()
+{   // {{{
+
+    // Print header.
+    print_header("Unit test for DirWalker class");
+
+    // Returns all entries of the walk in the sorted order.
+    const auto walk = [](const Path& root, uint16_t max_depth, size_t max_entries) noexcept -> Vector<String>
+    {
+        DirWalker walker(root, max_depth, max_entries, 4);
+        walker.wait(5.0);
+
+        Vector<String> paths;
+        assert(walker.fetch(paths));
+        std::sort(paths.begin(), paths.end());
+        return paths;
+    };
+
+    // Prepare a directory tree with ".gitignore".
+    const Path path_dir = Path("/tmp") / ("nishiki_" + get_random_string(16));
+    for (const char* name : {".git", ".hidden", "build/obj", "src/app/core", "src/lib"})
+        std::filesystem::create_directories(path_dir / name);
+    for (const char* name : {".hidden/x.cc", "build/obj/main.o", "src/app/core/main.cc", "src/app/core/main.o", "src/app/.env", "src/lib/util.cc", "src/lib/keep.log", "src/lib/skip.log"})
+        fclose(fopen((path_dir / name).c_str(), "wt"));
+
+    std::ofstream(path_dir / ".gitignore") << "# comment\n/build/\n*.o\n";
+    std::ofstream(path_dir / "src" / "lib" / ".gitignore") << "*.log\n!keep.log\n";
+
+    // Test 1: all entries except hidden directories and ignored entries.
+    assert((walk(path_dir, 16, 1000) == Vector<String>{".gitignore", "src/", "src/app/", "src/app/.env", "src/app/core/", "src/app/core/main.cc",
+                                                       "src/lib/", "src/lib/.gitignore", "src/lib/keep.log", "src/lib/util.cc"}));
+
+    // Test 2: the rules of ".gitignore" in the ancestors are applied.
+    assert((walk(path_dir / "src" / "app", 16, 1000) == Vector<String>{".env", "core/", "core/main.cc"}));
+
+    // Test 3: the depth and the number of entries are bounded.
+    assert((walk(path_dir, 1, 1000) == Vector<String>{".gitignore", "src/", "src/app/", "src/lib/"}));
+    assert((walk(path_dir, 16, 1).size() == 2));
+
+    // Test 4: the walk of a missing directory finishes without entries.
+    assert((walk(path_dir / "not_exist", 16, 1000).size() == 0));
+
+    // Clean up.
+    std::filesystem::remove_all(path_dir);
+
+}   // }}}
+
+static void test_EditHelper()
+{   // {{{
+
+    // Print header.
+    print_header("Unit test for EditHelper class");
+
+    EditHelper helper({8, 80});
+
+    // Test 1: candidates are narrowed while the query grows.
+    assert(helper.candidate(StringX("ls ../source/hist_")).size() > 0);
+    assert(helper.complete(StringX("ls ../source/hist_")) == StringX("ls ../source/hist_"));
+    helper.candidate(StringX("ls ../source/hist_w"));
+    assert(helper.complete(StringX("ls ../source/hist_w")) == StringX("ls ../source/hist_writer."));
+    helper.candidate(StringX("ls ../source/hist_wx"));
+    assert(helper.complete(StringX("ls ../source/hist_wx")) == StringX("ls ../source/hist_wx"));
+
+    // Test 2: candidates are recomputed after backspace.
+    helper.candidate(StringX("ls ../source/hist_l"));
+    assert(helper.complete(StringX("ls ../source/hist_l")) == StringX("ls ../source/hist_log."));
+
+    // Test 3: candidates of the provider are computed on the worker thread without waiting.
+    helper.candidate(StringX("git bra"), false);
+    for (uint16_t n = 0; (n < 100) and (helper.complete(StringX("git bra")) != StringX("git branch ")); ++n)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        helper.candidate(StringX("git bra"), false);
+    }
+    assert(helper.complete(StringX("git bra")) == StringX("git branch "));
+
+    // Test 4: the output of SHELL completion is cached (the second call never waits).
+    helper.candidate(StringX("git checkout "));
+    const StringX completed = helper.complete(StringX("git checkout "));
+    helper.candidate(StringX("ls ../source/"));
+    helper.candidate(StringX("git checkout "), false);
+    assert(helper.complete(StringX("git checkout ")) == completed);
+
+    // Test 5: fuzzy matching of paths, where the matched characters are decorated.
+    config.fuzzy_completion = true;
+    EditHelper helper_fuzzy({8, 80});
+    const Vector<StringX> lines = helper_fuzzy.candidate(StringX("ls ../source/hwr"));
+    assert(std::any_of(lines.begin(), lines.end(), [](const StringX& line) { return line.string().find(config.fuzzy_match_pre) != String::npos; }));
+    assert(helper_fuzzy.complete(StringX("ls ../source/hwr")) == StringX("ls ../source/hwr"));
+    helper_fuzzy.candidate(StringX("ls ../source/hwrh"));
+    assert(helper_fuzzy.complete(StringX("ls ../source/hwrh")) == StringX("ls ../source/hist_writer.hxx "));
+    config.fuzzy_completion = false;
+
+    // Test 6: candidates are shown page by page with the number of the hidden candidates.
+    const Path path_dir = Path("/tmp") / ("nishiki_" + get_random_string(16));
+    std::filesystem::create_directory(path_dir);
+    for (const char* name : {"gitcmd_01", "gitcmd_02", "gitcmd_03", "gitcmd_04", "gitcmd_05", "gitcmd_06", "gitcmd_07", "gitcmd_08"})
+        fclose(fopen((path_dir / name).c_str(), "wt"));
+
+    const String env_path = std::getenv("PATH");
+    setenv("PATH", path_dir.c_str(), 1);
+    EditHelper pager({2, 40});
+    Vector<StringX> pages = pager.candidate(StringX("gitc"));
+    assert((pages.size() == 2) and pages[0].string().starts_with("gitcmd_01") and (pages[1].string().find("5 more") != String::npos));
+    pages = pager.scroll(1);
+    assert(pages[0].string().starts_with("gitcmd_04") and (pages[1].string().find("gitcmd_05") == 0));
+    assert(pager.scroll(1)[0].string().starts_with("gitcmd_04"));
+    assert(pager.candidate(StringX("gitc"))[0].string().starts_with("gitcmd_04"));
+    assert(pager.scroll(-1)[0].string().starts_with("gitcmd_01"));
+    assert(pager.complete(StringX("gitc")) == StringX("gitcmd_0"));
+    assert(pager.candidate(StringX("gitcm"))[0].string().starts_with("gitcmd_01"));
+    setenv("PATH", env_path.c_str(), 1);
+
+    // Test 7: paths under the directory before "**" are completed recursively.
+    std::filesystem::create_directories(path_dir / "src" / "app" / "core");
+    std::filesystem::create_directories(path_dir / "src" / "lib");
+    for (const char* name : {"src/app/core/handler.cc", "src/app/core/helper.cc", "src/lib/handler.hh"})
+        fclose(fopen((path_dir / name).c_str(), "wt"));
+
+    const String root = path_dir.string() + "/src/";
+    EditHelper walker({8, 80});
+    walker.candidate(StringX(("ls " + root + "**/h").c_str()));
+    assert(walker.complete(StringX(("ls " + root + "**/h").c_str())) == StringX(("ls " + root + "**/h").c_str()));
+    walker.candidate(StringX(("ls " + root + "**/handler.c").c_str()));
+    assert(walker.complete(StringX(("ls " + root + "**/handler.c").c_str())) == StringX(("ls " + root + "app/core/handler.cc ").c_str()));
+    walker.candidate(StringX(("ls " + root + "**/core/he").c_str()));
+    assert(walker.complete(StringX(("ls " + root + "**/core/he").c_str())) == StringX(("ls " + root + "app/core/helper.cc ").c_str()));
+    std::filesystem::remove_all(path_dir);
+
+    // Test 8: the real-time completion falls back to OPTION when the plugin answers nothing, where
+    // the plugin is not asked again while "--help" is running (see the PLUGIN rule in main).
+    EditHelper plugin({8, 80});
+    uint16_t n_calls = 0;
+    plugin.candidate(StringX("nishiki_plugin --"), false);
+    for (uint16_t n = 0; n < 20; ++n)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        if (not plugin.is_ready())
+            continue;
+
+        plugin.candidate(StringX("nishiki_plugin --"), false);
+        ++n_calls;
+    }
+    assert((not plugin.is_ready()) and (n_calls <= 2));
+
+    // Test 9: the fuzzy matching decorates whole UTF-8 characters of the candidates.
+    config.fuzzy_completion = true;
+    std::filesystem::create_directory(path_dir);
+    fclose(fopen((path_dir / "日本語.txt").c_str(), "wt"));
+    EditHelper helper_utf8({8, 80});
+    const Vector<StringX> lines_utf8 = helper_utf8.candidate(StringX(("ls " + path_dir.string() + "/本").c_str()));
+    assert(std::any_of(lines_utf8.begin(), lines_utf8.end(), [](const StringX& line) { return line.string().find(String(config.fuzzy_match_pre) + "本" + config.fuzzy_match_post) != String::npos; }));
+    config.fuzzy_completion = false;
+    std::filesystem::remove_all(path_dir);
+
+}   // }}}
+
+static void test_GitIndex()
+{   // {{{
+
+    // Print header.
+    print_header("Unit test for GitIndex class");
+
+    // Prepare a git work tree, where "build" and "src/new.cc" are not tracked.
+    const Path path_dir = Path("/tmp") / ("nishiki_" + get_random_string(16));
+    std::filesystem::create_directories(path_dir / "src" / "app");
+    std::filesystem::create_directories(path_dir / "build");
+    for (const char* name : {"README.md", "build/out.o", "src/.clang-format", "src/app/main.cc", "src/new.cc", "src/util.cc"})
+        fclose(fopen((path_dir / name).c_str(), "wt"));
+
+    const String cd = "cd " + path_dir.string() + " && ";
+    assert(std::system((cd + "git init -q && git add README.md src/.clang-format src/app/main.cc src/util.cc").c_str()) == 0);
+
+    GitIndex index;
+    Vector<String> names;
+
+    // Test 1: the tracked entries in the directory, where directories come first.
+    assert(index.list(path_dir / "src", "", 128, false, names) and (names == Vector<String>{"app/", "util.cc"}));
+    assert(index.list(path_dir / "src", "", 128, true, names) and (names == Vector<String>{"app/", ".clang-format", "util.cc"}));
+    assert(index.list(path_dir / "src", "u", 128, false, names) and (names == Vector<String>{"util.cc"}));
+    assert(index.list(path_dir, "", 128, false, names) and (names == Vector<String>{"src/", "README.md"}));
+    assert(index.list(path_dir, "", 1, false, names) and (names == Vector<String>{"src/"}));
+
+    // Test 2: the directories without tracked files and the directories out of the work tree
+    // should be listed from the file system.
+    assert(not index.list(path_dir / "build", "", 128, false, names));
+    assert(not index.list(path_dir / ".git", "", 128, true, names));
+    assert(not index.list(path_dir.parent_path(), "", 128, false, names));
+
+    // Test 3: the index file is parsed again when modified, including the version 4.
+    assert(std::system((cd + "git add src/new.cc && git update-index --index-version 4").c_str()) == 0);
+    assert(index.list(path_dir / "src", "", 128, false, names) and (names == Vector<String>{"app/", "new.cc", "util.cc"}));
+    assert((GitIndex::parse(path_dir / ".git" / "index")->offsets.size() == 5));
+
+    // Test 4: path completion from the git index, optionally merged with untracked entries.
+    const StringX lhs = StringX(("ls " + path_dir.string() + "/b").c_str());
+    config.git_completion = true;
+    EditHelper helper({8, 80});
+    helper.candidate(lhs);
+    assert(helper.complete(lhs) == lhs);
+    config.git_completion_untracked = true;
+    EditHelper helper_untracked({8, 80});
+    helper_untracked.candidate(lhs);
+    assert(helper_untracked.complete(lhs) == StringX(("ls " + path_dir.string() + "/build/").c_str()));
+    config.git_completion = false;
+    config.git_completion_untracked = false;
+
+    // Clean up.
+    std::filesystem::remove_all(path_dir);
+
+}   // }}}
+
+static void test_HistCompleter()
+{   // {{{
+
+    // Print header.
+    print_header("Unit test for HistCompleter class");
+
+    // Prepare histories.
+    Deque<StringX> hists = {StringX("git status"), StringX("git stash"), StringX("ls -l"), StringX("git status -s")};
+
+    // Test 1: the most recent history is returned.
+    HistCompleter histcmp;
+    histcmp.update(hists);
+    assert(histcmp.complete(StringX("git st")) == StringX("atus -s"));
+    assert(histcmp.complete(StringX("git sta")) == StringX("tus -s"));
+    assert(histcmp.complete(StringX("git stas")) == StringX("h"));
+    assert(histcmp.complete(StringX("l")) == StringX("s -l"));
+    assert(histcmp.complete(StringX("git x")) == StringX(""));
+    assert(histcmp.complete(StringX("")) == StringX(""));
+
+    // Test 2: the search resumes from the previous query while the query grows.
+    assert(histcmp.complete(StringX("g")) == StringX("it status -s"));
+    assert(histcmp.complete(StringX("git s")) == StringX("tatus -s"));
+    assert(histcmp.complete(StringX("git stas")) == StringX("h"));
+    assert(histcmp.complete(StringX("git stax")) == StringX(""));
+    assert(histcmp.complete(StringX("git staxx")) == StringX(""));
+    assert(histcmp.complete(StringX("git sta")) == StringX("tus -s"));
+
+    // Test 3: incremental update.
+    hists.push_back(StringX("git stash pop"));
+    histcmp.update(hists);
+    assert(histcmp.complete(StringX("git st")) == StringX("ash pop"));
+    assert(histcmp.complete(StringX("git status")) == StringX(" -s"));
+
+    // Test 4: frequently used history is preferred.
+    hists.push_back(StringX("ls -l"));
+    hists.push_back(StringX("ls -a"));
+    histcmp.update(hists);
+    assert(histcmp.complete(StringX("ls")) == StringX(" -l"));
+
+    // Test 5: failed history and history run in the other directory are not preferred.
+    const Path path_log = Path("/tmp") / ("nishiki_" + get_random_string(16) + ".bin");
+    {
+        HistLog log(path_log);
+        log.append("make test", "/tmp/a", 0, 0, 0);
+        log.append("make all", "/tmp/b", 0, 0, 0);
+        log.append("make clean", "/tmp/a", 0, 2, 0);
+        hists.push_back(StringX("make test"));
+        hists.push_back(StringX("make all"));
+        hists.push_back(StringX("make clean"));
+        histcmp.update(hists, &log);
+    }
+    assert(histcmp.complete(StringX("make")) == StringX(" all"));
+    histcmp.set_cwd("/tmp/a");
+    assert(histcmp.complete(StringX("make")) == StringX(" test"));
+    histcmp.set_cwd("/tmp/c");
+    assert(histcmp.complete(StringX("make c")) == StringX("lean"));
+    for (const char* suffix : {"", ".idx", ".dirs"})
+        std::filesystem::remove(Path(path_log.string() + suffix));
+
+}   // }}}
+
+static void test_HistIndex()
+{   // {{{
+
+    // Print header.
+    print_header("Unit test for HistIndex class");
+
+    // Prepare histories.
+    Deque<StringX> hists = {StringX("docker run --net=host nginx"), StringX("ls -l"),
+                            StringX("docker run --net=host redis"), StringX("ls -l"), StringX("echo host")};
+
+    // Test 1: search the unindexed histories.
+    HistIndex histidx;
+    histidx.update(hists);
+    assert(histidx.size_indexed() == 0);
+    assert(histidx.find("--net=host", 10) == Vector<uint32_t>({2, 0}));
+    assert(histidx.find("host", 10) == Vector<uint32_t>({4, 2, 0}));
+    assert(histidx.find("ls", 10) == Vector<uint32_t>({3}));
+    assert(histidx.find("xyz", 10).size() == 0);
+    assert(histidx.get(2) == "docker run --net=host redis");
+
+    // Test 2: search the indexed histories and the unindexed tail.
+    histidx.compact(true);
+    hists.push_back(StringX("ssh host"));
+    histidx.update(hists);
+    assert(histidx.size_indexed() == 5);
+    assert(histidx.find("--net=host", 10) == Vector<uint32_t>({2, 0}));
+    assert(histidx.find("host", 10) == Vector<uint32_t>({5, 4, 2, 0}));
+    assert(histidx.find("host", 2) == Vector<uint32_t>({5, 4}));
+    assert(histidx.find("ls", 10) == Vector<uint32_t>({3}));
+    assert(histidx.find("xyz", 10).size() == 0);
+
+    // Test 3: compare with the linear search.
+    Deque<StringX> randoms;
+    for (uint32_t n = 0; n < 300; ++n)
+        randoms.push_back(StringX(get_random_string(1 + n % 20).substr(0, 1 + n % 7).c_str()));
+    HistIndex randidx;
+    randidx.update(randoms);
+    randidx.compact(true);
+    bool all_matched = true;
+    for (const String query : {"A", "AB", "0", "F1", "9"})
+    {
+        Vector<uint32_t> expected;
+        Set<String> found;
+        for (uint32_t n = randoms.size(); n > 0; --n)
+            if ((randoms[n - 1].string().find(query) != String::npos) and found.insert(randoms[n - 1].string()).second)
+                expected.push_back(n - 1);
+        all_matched = all_matched and (randidx.find(query, 1000) == expected);
+    }
+    assert(all_matched);
+
+    // Test 4: the suffix array is built on the background thread, and used from the next update.
+    HistIndex bgidx;
+    bgidx.update(randoms);
+    bgidx.compact();
+    for (uint16_t n = 0; (n < 500) and (bgidx.size_indexed() < randoms.size()); ++n)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        bgidx.update(randoms);
+    }
+    assert(bgidx.size_indexed() == randoms.size());
+
+}   // }}}
+
+static void test_HistLog()
+{   // {{{
+
+    // Print header.
+    print_header("Unit test for HistLog class");
+
+    // Prepare temporary file paths.
+    const Path path_log = Path("/tmp") / ("nishiki_" + get_random_string(16) + ".bin");
+    const Path path_txt = Path(path_log.string() + ".txt");
+
+    // Prepare a text history file to be imported.
+    FILE *ofp = fopen(path_txt.c_str(), "wt");
+    fputs("ls -l\ngit status\n", ofp);
+    fclose(ofp);
+
+    // Test 1: import and append.
+    {
+        HistLog log(path_log);
+        assert(log.import_text(path_txt) == 2);
+        log.append("git diff", "/tmp", 100, 0, 12);
+        log.append("git push", "/home", 200, 1, 34);
+        assert(log.size() == 4);
+    }
+
+    // Test 2: reload and lookup.
+    HistLog log(path_log);
+    assert(log.size() == 4);
+    assert(log.command(3) == "git push");
+    assert(log.entry(3).exit_code == 1);
+    assert(log.entry(3).duration == 34);
+    assert(log.directory(log.entry(2).cwd_id) == "/tmp");
+    assert(log.find_by_time(100, 200) == (Pair<uint32_t, uint32_t>(2, 3)));
+    assert(log.find_by_dir("/home").size() == 1);
+    assert(log.find_by_prefix("git ") == (Vector<uint32_t>{1, 2, 3}));
+    assert(log.find_by_prefix("vim").size() == 0);
+
+    // Test 3: repair the index from the log.
+    std::filesystem::remove(Path(path_log.string() + ".idx"));
+    assert(HistLog(path_log).find_by_prefix("git d") == (Vector<uint32_t>{2}));
+
+    // Test 4: two sessions which append to the same log register different directories, and the
+    // index written by the next load is reused without being rebuilt.
+    {
+        HistLog session1(path_log), session2(path_log);
+        session1.append("make", "/usr", 300, 0, 1);
+        session2.append("cmake", "/var", 400, 0, 1);
+    }
+
+    HistLog shared(path_log);
+    assert((shared.size() == 6) and (shared.directory(shared.entry(4).cwd_id) == "/usr") and (shared.directory(shared.entry(5).cwd_id) == "/var"));
+    assert(std::filesystem::file_size(Path(path_log.string() + ".idx")) == 6 * sizeof(HistLog::Entry));
+    assert(HistLog(path_log).find_by_prefix("make") == (Vector<uint32_t>{4}));
+    assert(std::filesystem::file_size(Path(path_log.string() + ".idx")) == 6 * sizeof(HistLog::Entry));
+
+    // Test 5: the directories of the same hash are registered by two sessions with different IDs.
+    {
+        HistLog session1(path_log), session2(path_log);
+        session1.append("make", "/d229599", 500, 0, 1);
+        session2.append("make", "/d432382", 600, 0, 1);
+        assert(session2.find_by_dir("/d432382").size() == 1);
+    }
+
+    HistLog collided(path_log);
+    assert((collided.directory(collided.entry(6).cwd_id) == "/d229599") and (collided.directory(collided.entry(7).cwd_id) == "/d432382"));
+    assert((collided.find_by_dir("/d229599") == Vector<uint32_t>{6}) and (collided.find_by_dir("/d432382") == Vector<uint32_t>{7}));
+
+    // Test 6: the text history is imported only once by the sessions started at the same time.
+    const Path path_new = Path(path_log.string() + ".new");
+    {
+        HistLog session1(path_new), session2(path_new);
+        assert((session1.import_text(path_txt) == 2) and (session2.import_text(path_txt) == 0));
+    }
+    assert(HistLog(path_new).find_by_prefix("ls") == (Vector<uint32_t>{0}));
+    assert(HistLog(path_new).size() == 2);
+
+    // Clean up temporary files.
+    for (const char* suffix : {"", ".idx", ".dirs", ".txt", ".new", ".new.idx", ".new.dirs"})
+        std::filesystem::remove(Path(path_log.string() + suffix));
+
+}   // }}}
+
+static void test_HistManager()
+{   // {{{
+
+    // Print header.
+    print_header("Unit test for HistManager class");
+
+    // Use temporary files as history files.
+    const String path_hist = "/tmp/nishiki_" + get_random_string(16) + ".txt";
+    const String path_blog = path_hist + ".bin";
+    config.path_history = path_hist.c_str();
+    config.path_histlog = path_blog.c_str();
+    config.share_history = true;
+
+    // Test 1: histories appended by the other session are read by sync.
+    HistManager histmn1, histmn2;
+    histmn1.append(StringX("echo 1"));
+    histmn1.flush();
+    assert(histmn2.sync() == 1);
+    histmn2.append(StringX("echo 2"));
+    histmn2.flush();
+    assert(histmn1.get_hists().size() == 1);
+    assert(histmn2.get_hists().size() == 2);
+    assert(histmn2.sync() == 0);
+    assert(histmn1.sync() == 1);
+    assert(histmn1.sync() == 0);
+    assert(histmn1.get_hists().back() == StringX("echo 2"));
+
+    // Test 2: the history file is loaded when constructed.
+    assert(HistManager().get_hists().size() == 2);
+
+    // Test 3: the binary history log is written by the background writer.
+    // The log has 2 histories imported by the HistManager instance in Test 2.
+    histmn1.record(StringX("echo 1"), "/tmp", 0, 0, 0);
+    histmn1.flush();
+    assert(HistLog(Path(path_blog)).size() == 3);
+
+    // Clean up temporary files and restore config values.
+    for (const String& path : {path_hist, path_blog, path_blog + ".idx", path_blog + ".dirs"})
+        std::filesystem::remove(path);
+    config = NishikiConfig();
+
+}   // }}}
+
+static void test_HistSearch()
+{   // {{{
+
+    // Print header.
+    print_header("Unit test for HistSearch class");
+
+    // Test 1: fuzzy matching scores.
+    Vector<uint16_t> positions;
+    assert(HistSearch::score("git status", "gst", &positions) > 0);
+    assert(positions == Vector<uint16_t>({0, 4, 5}));
+    assert(HistSearch::score("git status", "gtx") < 0);
+    assert(HistSearch::score("git status", "GST") < 0);
+    assert(HistSearch::score("Git Status", "gst") > 0);
+    assert(HistSearch::score("git status", "stat") > HistSearch::score("git set tag", "stat"));
+    assert((HistSearch::charmask("git status") & HistSearch::charmask("gst")) == HistSearch::charmask("gst"));
+
+    // Prepare histories.
+    Deque<StringX> hists = {StringX("git status"), StringX("ls -l"), StringX("git stash"), StringX("make test")};
+
+    // Test 2: search and incremental narrowing.
+    HistSearch histsrch;
+    histsrch.update(hists);
+    assert(histsrch.search("", 10).size() == 4);
+    assert(histsrch.get(histsrch.search("", 10)[0]) == "make test");
+    assert(histsrch.search("gs", 10).size() == 2);
+    assert(histsrch.get(histsrch.search("gs", 10)[0]) == "git stash");
+    assert(histsrch.search("gsta", 10).size() == 2);
+    assert(histsrch.search("gstat", 10).size() == 1);
+    assert(histsrch.get(histsrch.search("gstat", 10)[0]) == "git status");
+    assert(histsrch.search("gsta", 1).size() == 1);
+
+    // Test 3: duplicated histories are unified and moved to the most recent.
+    hists.push_back(StringX("git status"));
+    histsrch.update(hists);
+    assert(histsrch.size() == 4);
+    assert(histsrch.get(histsrch.search("gs", 10)[0]) == "git status");
+
+}   // }}}
+
+static void test_OptCache()
+{   // {{{
+
+    // Print header.
+    print_header("Unit test for OptCache class");
+
+    // Prepare a temporary cache file path.
+    const Path path_cache = Path("/tmp") / ("nishiki_" + get_random_string(16)) / "options.txt";
+
+    // Test 1: parse the help message.
+    const String help = "Usage: ls [OPTION]...\n  -a, --all      do not ignore entries\n      --color=WHEN  colorize\n";
+    const OptCache::Table table = OptCache::parse(help);
+    assert(table.size() == 3);
+    assert(table.at(StringX("-a")) == StringX("-a, --all      do not ignore entries"));
+    assert(table.contains(StringX("--color")));
+
+    // Test 2: commands are resolved in PATH.
+    assert(OptCache::resolve("ls").size() > 0);
+    assert(OptCache::resolve("not_exist_command").size() == 0);
+    assert(OptCache::resolve("./ls").size() == 0);
+
+    // Test 3: the stored table is loaded from the cache file by another instance.
+    {
+        OptCache cache(path_cache);
+        OptCache::Table got;
+        assert(not cache.get("ls", got));
+        assert(cache.put("ls", help).size() == 3);
+        assert(cache.put("not_exist_command", help).size() == 3);
+        assert(cache.get("ls", got) and (got.size() == 3));
+        assert(not cache.get("not_exist_command", got));
+    }
+    {
+        OptCache cache(path_cache);
+        OptCache::Table got;
+        assert(cache.get("ls", got) and (got == table));
+    }
+
+    // Test 4: the outdated tables are dropped and the cache file is rewritten.
+    FILE* ofp = fopen(path_cache.c_str(), "a");
+    fputs("# /not_exist/ls\t1\t2\t3.4\n-x\tdesc\n", ofp);
+    fclose(ofp);
+    {
+        OptCache cache(path_cache);
+        OptCache::Table got;
+        assert(cache.get("ls", got) and (got == table));
+    }
+    std::ifstream ifs(path_cache);
+    const String content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    assert(content.find("/not_exist/ls") == String::npos);
+
+    // Test 5: no temporary file is left after the rewrite, where only the lock file is added.
+    const auto n_files = std::distance(std::filesystem::directory_iterator(path_cache.parent_path()), std::filesystem::directory_iterator());
+    assert((n_files == 2) and std::filesystem::exists(path_cache.string() + ".lock"));
+
+    // Clean up.
+    std::filesystem::remove_all(path_cache.parent_path());
+
+}   // }}}
+
 static void test_PathX()
 {   // {{{
 
@@ -165,6 +1090,7 @@ static void test_PathX()
     // Test 5: listdir.
     assert(PathX("/not_exists").listdir().size() == 0);
     assert(PathX(".").listdir(1).size() == 1);
+    assert(PathX("../source").listdir(128, "path_x.").size() == 2);
 
 }   // }}}
 
@@ -254,14 +1180,27 @@ static void test_utils()
     values1.push_back(StringX("辰巳"));
     assert(column(values1, 20, 3, 2)[0] == StringX("Tokyo    江東区   "));
 
-    // Test 2: split function.
+    // Test 2: column function with a dense grid which cannot be shown entirely.
+    size_t n_shown = 0;
+    const Vector<StringX> values2(1000, StringX("ab"));
+    const Vector<StringX> lines2 = column(values2, 80, 5, 3, &n_shown);
+    assert((lines2.size() == 5) and (n_shown == 80) and (lines2[4].width() == 80));
+    assert(lines2[0].string().starts_with("ab   ab   ab"));
+
+    // Test 3: split function.
     assert(split("this,is,csv", ",").size() == 3);
     assert(split("this is csv", "").size() == 1);
 
-    // Test 3: strip function.
+    // Test 4: strip function.
     assert(strip(" hello ", true, false) == "hello ");
     assert(strip(" hello ", false, true) == " hello");
 
+    // Test 5: highlight function decorates whole UTF-8 characters.
+    assert(highlight("ab", {1}, "[", "]") == "a[b]");
+    assert(highlight("東京x", {3, 4, 5, 6}, "[", "]") == "東[京][x]");
+    assert(highlight("東京", {4}, "[", "]") == "東[京]");
+    assert(highlight("> ab", {0, 5}, "[", "]", 2) == "> [a]b");
+
 }   // }}}
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -313,7 +1252,7 @@ static void test_readcmd()
     assert(run_test_readcmd("ls Makefile \n", "ls Makefile ", ""));
     assert(run_test_readcmd("git bra\t\n", "git branch ", ""));
     assert(run_test_readcmd("ls ./objects\t\n", "ls ./objects/", ""));
-    assert(run_test_readcmd("ls ../source/file_\t\n", "ls ../source/file_type.", ""));
+    assert(run_test_readcmd("ls ../source/file_t\t\n", "ls ../source/file_type.", ""));
 
     // Edit characters in edit mode.
     assert(run_test_readcmd("ls \x1B\x1A 0a\x08\n", "", "s "));
@@ -338,6 +1277,11 @@ static void test_readcmd()
     // History completions.
     assert(run_test_readcmd("previ\x0E\n", "previous input ", ""));
 
+    // Fuzzy history search.
+    assert(run_test_readcmd("\x15pin\n\n", "previous input", ""));
+    assert(run_test_readcmd("ls\x15pin\x1B\x1A\n", "ls", ""));
+    assert(run_test_readcmd("\x12s in\n\n", "previous input", ""));
+
     // Ctrl-C and Ctrl-D.
     assert(run_test_readcmd("\x03", "", ""));
     assert(run_test_readcmd("\x04", "^D", ""));
@@ -354,9 +1298,28 @@ static void test_readcmd()
 int32_t main(void)
 {   // {{{
 
+    // Completion rule of the plugin which answers nothing. The rules are compiled at the first
+    // completion, so the rule is registered before all tests.
+    config.completions.insert(config.completions.begin(), {{"nishiki_plugin", ">>", ".*"}, EditHelper::CompType::PLUGIN, "while read -r id rest; do echo \"$id\"; done"});
+
     // Run all unittest functions.
     test_CharX();
+    test_CmdIndex();
+    test_CmdPool();
+    test_CoProc();
+    test_CompRules();
     test_FileType();
+    test_dir_cache();
+    test_DirWalker();
+    test_file_stat();
+    test_EditHelper();
+    test_GitIndex();
+    test_HistCompleter();
+    test_HistIndex();
+    test_HistLog();
+    test_HistManager();
+    test_HistSearch();
+    test_OptCache();
     test_PathX();
     test_preview();
     test_StringX();